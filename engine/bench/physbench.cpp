@@ -0,0 +1,288 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Headless physics stress test. Builds a seeded scene of N circles, runs a fixed number of ticks and
+// reports step times, pair counts and heap allocations, so broadphase and solver changes can be compared.
+// A hash of every body's final state is printed too, which must not change with the thread count.
+//
+//     physbench [--bodies N] [--density D] [--static F] [--steps S] [--warmup W] [--seed X]
+//               [--radius R] [--broadphase grid|tree|sweep] [--threads T] [--snapshot]
+//     physbench --momentum N
+//
+// Without --bodies it runs the 1k, 10k and 100k suite. --snapshot saves and restores the world after every
+// tick and times both; since it restores the state it just saved, the hash must match a run without it.
+// --momentum instead checks that a body touching N others at once, more than the solver has colors for,
+// conserves linear momentum, and fails if it doesn't.
+
+#include <physics/physics.h>
+
+#include <new>
+#include <array>
+#include <cmath>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+// Every heap allocation in the process goes through here so steady-state allocations can be counted
+std::atomic<std::uint64_t> allocation_count{0};
+
+auto operator new(std::size_t size) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (auto memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc{};
+}
+
+auto operator delete(void* memory) noexcept -> void { std::free(memory); }
+auto operator delete(void* memory, std::size_t) noexcept -> void { std::free(memory); }
+
+namespace {
+
+struct bench_config {
+    std::uint32_t bodies = 0;
+    float density = 0.3f;       // fraction of the world covered by circles
+    float static_fraction = 0.1f;
+    float radius = 8.f;
+    std::uint32_t steps = 300, warmup = 30;
+    std::uint32_t seed = 1;
+    xc::broadphase_type broadphase = xc::broadphase_type::eGrid;
+    std::uint32_t threads = xc::thread_pool::default_worker_count() + 1;
+    bool snapshot = false;
+};
+
+struct bench_result {
+    double mean_ms, p99_ms;
+    double pairs, contacts;     // per step
+    double allocations;         // per step, ticks only
+    double save_ms, restore_ms, snapshot_kb;
+    std::uint64_t hash;
+};
+
+auto constexpr TIME_STEP = 1.f / 60.f;
+auto constexpr MAX_SPEED = 120.f;
+
+// std::uniform_real_distribution differs between standard libraries; mt19937's raw output doesn't
+auto uniform(std::mt19937& rng, float const min, float const max) -> float {
+    return min + (max - min) * static_cast<float>(rng() >> 8) * (1.f / 16777216.f);
+}
+
+// FNV-1a over the pose and velocity of every body, in component order
+auto hash_bodies(std::vector<physics_body_component> const& bodies) -> std::uint64_t {
+    auto hash = std::uint64_t{14695981039346656037u};
+    auto const mix = [&hash](auto const& value) {
+        auto bytes = std::array<unsigned char, sizeof(value)>{};
+        std::memcpy(bytes.data(), &value, sizeof(value));
+        for (auto const byte : bytes) hash = (hash ^ byte) * 1099511628211u;
+    };
+
+    for (auto const& body : bodies) {
+        mix(body.position.x); mix(body.position.y); mix(body.rotation);
+        mix(body.velocity.x); mix(body.velocity.y); mix(body.angular_velocity);
+    }
+    return hash;
+}
+
+auto milliseconds_since(std::chrono::steady_clock::time_point const start) -> double {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto run(bench_config const& config) -> bench_result {
+    auto scene = xc::scene::create();
+    auto physics = xc::physics::create(scene, config.broadphase, config.radius * 8.f, std::max(config.threads, 1u) - 1);
+
+    // A square world sized so the circles cover `density` of it
+    auto const circle_area = xc::PI * config.radius * config.radius;
+    auto const world_size = std::sqrt(static_cast<float>(config.bodies) * circle_area / config.density);
+
+    auto rng = std::mt19937{config.seed};
+    for (auto i = std::uint32_t{0}; i < config.bodies; ++i) {
+        auto const position = xc::vector2{uniform(rng, 0.f, world_size), uniform(rng, 0.f, world_size)};
+        auto const is_dynamic = uniform(rng, 0.f, 1.f) >= config.static_fraction;
+
+        auto body = physics->create_body(position, config.radius, is_dynamic);
+        if (is_dynamic) body.velocity = xc::to_real2({uniform(rng, -MAX_SPEED, MAX_SPEED), uniform(rng, -MAX_SPEED, MAX_SPEED)});
+
+        scene->add_component<physics_body_component>(scene->create_entity(), body);
+    }
+
+    for (auto i = std::uint32_t{0}; i < config.warmup; ++i) physics->tick(TIME_STEP);
+
+    auto step_ms = std::vector<double>{};
+    step_ms.reserve(config.steps);
+
+    auto pairs = 0.0, contacts = 0.0, allocations = 0.0;
+    auto save_ms = 0.0, restore_ms = 0.0;
+    auto snapshot = std::vector<std::byte>{};
+
+    for (auto i = std::uint32_t{0}; i < config.steps; ++i) {
+        auto const allocations_before = allocation_count.load();
+        auto const start = std::chrono::steady_clock::now();
+        physics->tick(TIME_STEP);
+        step_ms.push_back(milliseconds_since(start));
+        allocations += static_cast<double>(allocation_count.load() - allocations_before);
+
+        pairs += physics->stats().candidate_pairs;
+        contacts += physics->stats().contacts;
+
+        if (config.snapshot) {
+            auto const save_start = std::chrono::steady_clock::now();
+            physics->save(snapshot);
+            save_ms += milliseconds_since(save_start);
+
+            auto const restore_start = std::chrono::steady_clock::now();
+            physics->restore(snapshot);
+            restore_ms += milliseconds_since(restore_start);
+        }
+    }
+
+    auto const steps = static_cast<double>(std::max(config.steps, 1u));
+
+    auto result = bench_result{};
+    result.mean_ms = std::accumulate(step_ms.begin(), step_ms.end(), 0.0) / steps;
+    result.pairs = pairs / steps;
+    result.contacts = contacts / steps;
+    result.allocations = allocations / steps;
+    result.save_ms = save_ms / steps;
+    result.restore_ms = restore_ms / steps;
+    result.snapshot_kb = static_cast<double>(snapshot.size()) / 1024.0;
+    result.hash = hash_bodies(scene->get_components<physics_body_component>());
+
+    if (!step_ms.empty()) {
+        auto const p99 = step_ms.begin() + static_cast<std::ptrdiff_t>((step_ms.size() - 1) * 99 / 100);
+        std::nth_element(step_ms.begin(), p99, step_ms.end());
+        result.p99_ms = *p99;
+    }
+
+    return result;
+}
+
+auto parse_broadphase(char const* name) -> xc::broadphase_type {
+    if (std::strcmp(name, "tree") == 0) return xc::broadphase_type::eTree;
+    if (std::strcmp(name, "sweep") == 0) return xc::broadphase_type::eSweep;
+    return xc::broadphase_type::eGrid;
+}
+
+auto broadphase_name(xc::broadphase_type const type) -> char const* {
+    switch (type) {
+        case xc::broadphase_type::eTree: return "tree";
+        case xc::broadphase_type::eSweep: return "sweep";
+        default: return "grid";
+    }
+}
+
+// A hub circle with `contacts` smaller ones overlapping it around its rim, all moving, in no gravity
+auto check_momentum(std::uint32_t const contacts, xc::broadphase_type const broadphase) -> bool {
+    auto constexpr RIM_RADIUS = 4.f;
+    auto const hub_radius = RIM_RADIUS * static_cast<float>(std::max(contacts, 8u)) / 2.f;
+
+    auto scene = xc::scene::create();
+    auto physics = xc::physics::create(scene, broadphase, hub_radius * 2.f);
+
+    auto entities = std::vector<xc::entity_id>{};
+    auto const add = [&](xc::vector2 const& position, float const radius, xc::vector2 const& velocity) {
+        auto body = physics->create_body(position, radius);
+        body.velocity = xc::to_real2(velocity);
+        body.damping = xc::real{0};
+
+        entities.push_back(scene->create_entity());
+        scene->add_component<physics_body_component>(entities.back(), body);
+    };
+
+    add({0.f, 0.f}, hub_radius, {30.f, -20.f});
+    for (auto i = std::uint32_t{0}; i < contacts; ++i) {
+        auto const angle = 2.f * xc::PI * static_cast<float>(i) / static_cast<float>(contacts);
+        auto const direction = xc::vector2{std::cos(angle), std::sin(angle)};
+        add(direction * (hub_radius + RIM_RADIUS - 1.f), RIM_RADIUS, direction * -50.f);
+    }
+
+    // Momentum and its scale, for a tolerance that doesn't depend on the masses involved. One tick keeps every
+    // contact touching.
+    auto const momentum = [&] {
+        auto total = std::array<double, 3>{};
+        for (auto const entity : entities) {
+            auto const& body = scene->get_component<physics_body_component>(entity);
+            auto const mass = 1.0 / static_cast<double>(body.inverse_mass);
+            total[0] += mass * static_cast<double>(body.velocity.x);
+            total[1] += mass * static_cast<double>(body.velocity.y);
+            total[2] += mass * (std::abs(static_cast<double>(body.velocity.x)) + std::abs(static_cast<double>(body.velocity.y)));
+        }
+        return total;
+    };
+
+    auto const before = momentum();
+    physics->tick(TIME_STEP);
+    auto const after = momentum();
+
+    auto const drift = std::hypot(after[0] - before[0], after[1] - before[1]) / before[2];
+    auto const passed = drift < 1e-3; // shared lanes lose about 1e-2, Q32.32 rounding alone 1e-8
+
+    std::printf("%-6s %u contacts: momentum (%.3f, %.3f) -> (%.3f, %.3f), %u solved, drift %.2e %s\n",
+                broadphase_name(broadphase), contacts, before[0], before[1], after[0], after[1],
+                physics->stats().contacts, drift, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+}
+
+auto main(int argc, char** argv) -> int {
+    auto config = bench_config{};
+    auto momentum_contacts = std::uint32_t{0};
+
+    for (auto i = 1; i < argc; ++i) {
+        auto const option = std::string{argv[i]};
+        if (option == "--snapshot") {
+            config.snapshot = true;
+            continue;
+        }
+
+        if (i + 1 == argc) {
+            std::fprintf(stderr, "missing value for %s\n", option.c_str());
+            return EXIT_FAILURE;
+        }
+        auto const value = argv[++i];
+
+        if (option == "--bodies") config.bodies = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (option == "--density") config.density = std::strtof(value, nullptr);
+        else if (option == "--static") config.static_fraction = std::strtof(value, nullptr);
+        else if (option == "--radius") config.radius = std::strtof(value, nullptr);
+        else if (option == "--steps") config.steps = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (option == "--warmup") config.warmup = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (option == "--seed") config.seed = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (option == "--broadphase") config.broadphase = parse_broadphase(value);
+        else if (option == "--threads") config.threads = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (option == "--momentum") momentum_contacts = static_cast<std::uint32_t>(std::strtoul(value, nullptr, 10));
+        else {
+            std::fprintf(stderr, "unknown option %s\n", option.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (momentum_contacts) return check_momentum(momentum_contacts, config.broadphase) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    auto suite = std::vector<std::uint32_t>{1'000, 10'000, 100'000};
+    if (config.bodies) suite = {config.bodies};
+
+    std::printf("%-8s %-6s %7s %8s %8s %10s %10s %10s %16s", "bodies", "bp", "threads", "mean ms", "p99 ms",
+                "pairs", "contacts", "allocs", "hash");
+    if (config.snapshot) std::printf(" %8s %10s %10s", "save ms", "restore ms", "KB");
+    std::printf("\n");
+
+    for (auto const bodies : suite) {
+        config.bodies = bodies;
+        auto const result = run(config);
+
+        std::printf("%-8u %-6s %7u %8.3f %8.3f %10.0f %10.0f %10.1f %016llx", bodies, broadphase_name(config.broadphase),
+                    std::max(config.threads, 1u), result.mean_ms, result.p99_ms, result.pairs, result.contacts,
+                    result.allocations, static_cast<unsigned long long>(result.hash));
+        if (config.snapshot) std::printf(" %8.3f %10.3f %10.1f", result.save_ms, result.restore_ms, result.snapshot_kb);
+        std::printf("\n");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -97,11 +97,11 @@ struct field_definition {
      * Possible values: `Hidden`, `ValueOnly`, `NameAndValue`, `EntityTile`, `Points`,
      * `PointStar`, `PointPath`, `PointPathLoop`, `RadiusPx`, `RadiusGrid`
      */
-    editor_display_mode editor_display_mode;
+    quicktype::editor_display_mode editor_display_mode;
     /**
      * Possible values: `Above`, `Center`, `Beneath`
      */
-    editor_display_pos editor_display_pos;
+    quicktype::editor_display_pos editor_display_pos;
     /**
      * Unique String identifier
      */
@@ -127,7 +127,7 @@ struct field_definition {
      * Possible values: &lt;`null`&gt;, `LangPython`, `LangRuby`, `LangJS`, `LangLua`, `LangC`,
      * `LangHaxe`, `LangMarkdown`, `LangJson`, `LangXml`
      */
-    std::shared_ptr<text_language_mode> text_language_mode;
+    std::shared_ptr<quicktype::text_language_mode> text_language_mode;
     /**
      * Internal type enum
      */
@@ -186,12 +186,12 @@ struct entity_definition {
     /**
      * Possible values: `DiscardOldOnes`, `PreventAdding`, `MoveLastOne`
      */
-    limit_behavior limit_behavior;
+    quicktype::limit_behavior limit_behavior;
     /**
      * If TRUE, the maxCount is a "per world" limit, if FALSE, it's a "per level". Possible
      * values: `PerLayer`, `PerLevel`, `PerWorld`
      */
-    limit_scope limit_scope;
+    quicktype::limit_scope limit_scope;
     double line_opacity;
     /**
      * Max instances count
@@ -208,7 +208,7 @@ struct entity_definition {
     /**
      * Possible values: `Rectangle`, `Ellipse`, `Tile`, `Cross`
      */
-    render_mode render_mode;
+    quicktype::render_mode render_mode;
     /**
      * If TRUE, the entity instances will be resizable horizontally
      */
@@ -232,7 +232,7 @@ struct entity_definition {
     /**
      * Possible values: `Cover`, `FitInside`, `Repeat`, `Stretch`
      */
-    tile_render_mode tile_render_mode;
+    quicktype::tile_render_mode tile_render_mode;
     /**
      * Tileset ID used for optional tile display
      */
@@ -323,7 +323,7 @@ struct auto_layer_rule_definition {
     /**
      * Checker mode Possible values: `None`, `Horizontal`, `Vertical`
      */
-    checker checker;
+    quicktype::checker checker;
     /**
      * If TRUE, allow rule to be matched by flipping its pattern horizontally
      */
@@ -366,7 +366,7 @@ struct auto_layer_rule_definition {
     /**
      * Defines how tileIds array is used Possible values: `Single`, `Stamp`
      */
-    tile_mode tile_mode;
+    quicktype::tile_mode tile_mode;
     /**
      * Unique Int identifier
      */
@@ -482,7 +482,7 @@ struct layer_definition {
      * Type of the layer as Haxe Enum Possible values: `IntGrid`, `Entities`, `Tiles`,
      * `AutoLayer`
      */
-    type layer_definition_type;
+    quicktype::type layer_definition_type;
     /**
      * Unique Int identifier
      */
@@ -906,7 +906,7 @@ struct level {
      * `__bgPos` for resulting position info. Possible values: &lt;`null`&gt;, `Unscaled`,
      * `Contain`, `Cover`, `CoverDirty`
      */
-    std::shared_ptr<bg_pos> level_bg_pos;
+    std::shared_ptr<quicktype::bg_pos> level_bg_pos;
     /**
      * The *optional* relative path to the level background image.
      */
@@ -1036,7 +1036,7 @@ struct ldtk {
      * "Image export" option when saving project. Possible values: `None`, `OneImagePerLayer`,
      * `OneImagePerLevel`
      */
-    image_export_mode image_export_mode;
+    quicktype::image_export_mode image_export_mode;
     /**
      * File format version
      */
@@ -1076,7 +1076,7 @@ struct ldtk {
      * An enum that describes how levels are organized in this project (ie. linearly or in a 2D
      * space). Possible values: `Free`, `GridVania`, `LinearHorizontal`, `LinearVertical`
      */
-    world_layout world_layout;
+    quicktype::world_layout world_layout;
 };
 }
 
@@ -0,0 +1,161 @@
+#ifndef ENGINE_CORE_FIXED_H
+#define ENGINE_CORE_FIXED_H
+
+#include <compare>
+#include <concepts>
+#include <type_traits>
+#include <algorithm>
+#include <limits>
+
+#include <core/types.h>
+
+namespace xc {
+
+// Two's complement fixed-point number with FractionBits fractional bits. Every operation is integer
+// arithmetic, so results are bit-identical on any compiler and instruction set. Products and quotients
+// are formed in Wide and then truncated back; multiplication rounds towards negative infinity and
+// division towards zero. Negation, addition, subtraction and multiplication wrap around on overflow,
+// being carried out in the unsigned type, so a result out of range is still the same on every build
+// rather than undefined. Conversions from floating point are explicit to keep float math out of
+// anything computed with it.
+template<typename Int, typename Wide, int FractionBits> class fixed_point {
+public:
+    auto static constexpr ONE = Int{1} << FractionBits;
+
+    constexpr fixed_point() = default;
+    template<std::integral T> explicit constexpr fixed_point(T const value) : _raw{static_cast<Int>(static_cast<Int>(value) * ONE)} {}
+    template<std::floating_point T> explicit constexpr fixed_point(T const value) : _raw{round(static_cast<double>(value) * ONE)} {}
+
+    auto static constexpr from_raw(Int const raw) -> fixed_point {
+        auto result = fixed_point{};
+        result._raw = raw;
+        return result;
+    }
+
+    auto constexpr raw() const -> Int { return _raw; }
+
+    template<std::floating_point T> explicit constexpr operator T() const { return static_cast<T>(_raw) / static_cast<T>(ONE); }
+
+    auto constexpr operator-() const -> fixed_point { return wrap(Unsigned{0} - static_cast<Unsigned>(_raw)); }
+
+    auto constexpr operator+(fixed_point const other) const -> fixed_point {
+        return wrap(static_cast<Unsigned>(_raw) + static_cast<Unsigned>(other._raw));
+    }
+
+    auto constexpr operator-(fixed_point const other) const -> fixed_point {
+        return wrap(static_cast<Unsigned>(_raw) - static_cast<Unsigned>(other._raw));
+    }
+
+    // The full product always fits in Wide; only the part kept after the shift can wrap
+    auto constexpr operator*(fixed_point const other) const -> fixed_point {
+        return wrap(static_cast<Unsigned>((static_cast<Wide>(_raw) * other._raw) >> FractionBits));
+    }
+
+    // Dividing by zero saturates to the extreme of the dividend's sign where floats go to infinity, and
+    // gives zero for zero over zero, so a degenerate normal comes out as the zero vector rather than a trap
+    auto constexpr operator/(fixed_point const other) const -> fixed_point {
+        if (other._raw == 0) {
+            if (_raw == 0) return fixed_point{};
+            return from_raw(_raw > 0 ? std::numeric_limits<Int>::max() : std::numeric_limits<Int>::min());
+        }
+        return from_raw(static_cast<Int>((static_cast<Wide>(_raw) * ONE) / other._raw));
+    }
+
+    auto constexpr operator+=(fixed_point const other) -> fixed_point& { return *this = *this + other; }
+    auto constexpr operator-=(fixed_point const other) -> fixed_point& { return *this = *this - other; }
+    auto constexpr operator*=(fixed_point const other) -> fixed_point& { return *this = *this * other; }
+    auto constexpr operator/=(fixed_point const other) -> fixed_point& { return *this = *this / other; }
+
+    auto constexpr operator<=>(fixed_point const&) const = default;
+
+    // Bitwise integer square root of the value scaled up by another ONE, so the result keeps its fraction
+    friend auto constexpr sqrt(fixed_point const value) -> fixed_point {
+        if (value._raw <= 0) return fixed_point{};
+
+        auto remainder = static_cast<Wide>(value._raw) * ONE;
+        auto result = Wide{0};
+        auto bit = Wide{1} << (sizeof(Wide) * 8 - 2);
+        while (bit > remainder) bit >>= 2;
+
+        while (bit != 0) {
+            if (remainder >= result + bit) {
+                remainder -= result + bit;
+                result = (result >> 1) + bit;
+            } else {
+                result >>= 1;
+            }
+            bit >>= 2;
+        }
+
+        return from_raw(static_cast<Int>(result));
+    }
+
+    friend auto constexpr abs(fixed_point const value) -> fixed_point { return value._raw < 0 ? -value : value; }
+
+    // Radians in, integer arithmetic throughout. The angle is brought within an eighth of a turn of zero
+    // against a π/2 carried to more bits than the value has, then Taylor series are summed with extra
+    // bits too, so the results are within a unit in the last place even for angles near the top of the range.
+    friend auto constexpr sin(fixed_point const angle) -> fixed_point {
+        auto const [quadrant, sine, cosine] = reduce_quarter_turns(angle);
+        return quadrant == 0 ? sine : quadrant == 1 ? cosine : quadrant == 2 ? -sine : -cosine;
+    }
+
+    friend auto constexpr cos(fixed_point const angle) -> fixed_point {
+        auto const [quadrant, sine, cosine] = reduce_quarter_turns(angle);
+        return quadrant == 0 ? cosine : quadrant == 1 ? -sine : quadrant == 2 ? -cosine : sine;
+    }
+
+private:
+    using Unsigned = std::make_unsigned_t<Int>;
+
+    auto static constexpr wrap(Unsigned const raw) -> fixed_point { return from_raw(static_cast<Int>(raw)); }
+
+    struct reduced_angle {
+        int quadrant; // quarter turns taken off, modulo 4
+        fixed_point sine, cosine;
+    };
+
+    // π/2 with 61 fractional bits, cut down to as many as its product with the quadrant can hold in Wide,
+    // and the series summed with as many as a product of two terms can
+    auto static constexpr WIDE_BITS = static_cast<int>(sizeof(Wide) * 8);
+    auto static constexpr HALF_PI_BITS = std::min(61, WIDE_BITS - static_cast<int>(sizeof(Int) * 8) + FractionBits - 2);
+    auto static constexpr SERIES_BITS = std::min(HALF_PI_BITS, (WIDE_BITS - 4) / 2);
+    auto static constexpr HALF_PI = static_cast<Wide>(0x3243f6a8885a308d) >> (61 - HALF_PI_BITS);
+
+    auto static constexpr reduce_quarter_turns(fixed_point const angle) -> reduced_angle {
+        auto const scaled = static_cast<Wide>(angle._raw) * (Wide{1} << (HALF_PI_BITS - FractionBits));
+        auto const quadrant = (scaled + (scaled < 0 ? -HALF_PI / 2 : HALF_PI / 2)) / HALF_PI;
+        auto const x = (scaled - quadrant * HALF_PI) >> (HALF_PI_BITS - SERIES_BITS);
+
+        // Horner form of x - x³/3! + x⁵/5! - ... and 1 - x²/2! + x⁴/4! - ..., far enough for |x| <= π/4
+        auto const one = Wide{1} << SERIES_BITS;
+        auto const square = x * x >> SERIES_BITS;
+
+        auto sine = one, cosine = one;
+        for (auto term = 13; term > 1; term -= 2) sine = one - (square * sine >> SERIES_BITS) / (term * (term - 1));
+        for (auto term = 14; term > 0; term -= 2) cosine = one - (square * cosine >> SERIES_BITS) / (term * (term - 1));
+        sine = x * sine >> SERIES_BITS;
+
+        auto const to_fixed = [](Wide const value) {
+            auto constexpr shift = SERIES_BITS - FractionBits;
+            return from_raw(static_cast<Int>((value + (Wide{1} << (shift - 1))) >> shift));
+        };
+
+        return {static_cast<int>(quadrant & 3), to_fixed(sine), to_fixed(cosine)};
+    }
+
+    auto static constexpr round(double const scaled) -> Int {
+        return static_cast<Int>(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+    }
+
+    Int _raw = 0;
+};
+
+// Q32.32, which holds squared distances across the whole map in pixels with room to spare
+#if defined(__SIZEOF_INT128__)
+using q32_32 = fixed_point<std::int64_t, __int128, 32>;
+#endif
+
+}
+
+#endif // ENGINE_CORE_FIXED_H
@@ -0,0 +1,13 @@
+#ifndef ENGINE_CORE_PROFILER_H
+#define ENGINE_CORE_PROFILER_H
+
+// Named zones for an external profiler. Building with TRACY_ENABLE, and Tracy's client on the include
+// path, sends them to Tracy; otherwise they compile away.
+#if defined(TRACY_ENABLE)
+#include <tracy/Tracy.hpp>
+#define profile_zone(name) ZoneScopedN(name)
+#else
+#define profile_zone(name) do {} while (0)
+#endif
+
+#endif // ENGINE_CORE_PROFILER_H
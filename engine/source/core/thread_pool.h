@@ -0,0 +1,109 @@
+#ifndef ENGINE_CORE_THREAD_POOL_H
+#define ENGINE_CORE_THREAD_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include <core/types.h>
+
+namespace xc {
+
+// Fixed set of workers for data-parallel loops. The calling thread joins in, so a pool without workers
+// (single core, or a web build without pthreads) simply runs every job inline.
+class thread_pool {
+public:
+    explicit thread_pool(std::uint32_t worker_count = default_worker_count()) {
+        _workers.reserve(worker_count);
+        for (auto i = std::uint32_t{0}; i < worker_count; ++i) _workers.emplace_back([this] { work(); });
+    }
+
+    ~thread_pool() {
+        {
+            auto lock = std::lock_guard{_mutex};
+            _stopping = true;
+        }
+        _wake.notify_all();
+
+        for (auto& worker : _workers) worker.join();
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    auto operator=(thread_pool const&) -> thread_pool& = delete;
+
+    auto static default_worker_count() -> std::uint32_t {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        return 0;
+#else
+        auto const cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+#endif
+    }
+
+    auto thread_count() const -> std::uint32_t { return static_cast<std::uint32_t>(_workers.size()) + 1; }
+
+    // Calls job(i) for every i in [0, count) and returns once all of them have finished. Which thread runs
+    // which index is unspecified, so jobs must only write to state owned by their index.
+    auto run(std::size_t const count, std::function<void(std::size_t)> const& job) -> void {
+        if (_workers.empty() || count < 2) {
+            for (auto i = std::size_t{0}; i < count; ++i) job(i);
+            return;
+        }
+
+        {
+            auto lock = std::lock_guard{_mutex};
+            _job = &job;
+            _count = count;
+            _next = 0;
+            _active = _workers.size();
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        drain();
+
+        auto lock = std::unique_lock{_mutex};
+        _done.wait(lock, [this] { return _active == 0; });
+        _job = nullptr;
+    }
+
+private:
+    auto work() -> void {
+        auto generation = std::uint64_t{0};
+
+        for (;;) {
+            auto lock = std::unique_lock{_mutex};
+            _wake.wait(lock, [&] { return _stopping || _generation != generation; });
+            if (_stopping) return;
+
+            generation = _generation;
+            lock.unlock();
+
+            drain();
+
+            lock.lock();
+            if (--_active == 0) _done.notify_one();
+        }
+    }
+
+    auto drain() -> void {
+        for (auto i = _next++; i < _count; i = _next++) (*_job)(i);
+    }
+
+    std::vector<std::thread> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _wake, _done;
+
+    std::function<void(std::size_t)> const* _job = nullptr;
+    std::size_t _count = 0, _active = 0;
+    std::atomic<std::size_t> _next = 0;
+    std::uint64_t _generation = 0;
+    bool _stopping = false;
+};
+
+}
+
+#endif // ENGINE_CORE_THREAD_POOL_H
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 #include <stdexcept>
+#include <type_traits>
 
 namespace xc {
 
@@ -35,6 +36,12 @@ template<typename T> struct vector<T,1> { T x; };
 template<typename T> struct vector<T,2> { T x, y; };
 using vector2 = vector<float,2>;
 
+template<typename T> struct is_vector : std::false_type {};
+template<typename T, std::size_t N> struct is_vector<vector<T,N>> : std::true_type {};
+
+// Keeps the generic operators below from being picked up by ADL for unrelated types in xc (e.g. iterators)
+template<typename A, typename B> concept vector_operands = is_vector<A>::value || is_vector<B>::value;
+
 auto constexpr op_add = [](auto a, auto b) -> decltype(a + b) { return a + b; };
 auto constexpr op_sub = [](auto a, auto b) -> decltype(a - b) { return a - b; };
 auto constexpr op_mul = [](auto a, auto b) -> decltype(a * b) { return a * b; };
@@ -59,17 +66,21 @@ template<typename A, class Op> auto constexpr map(Op const& op, vector<A,2> cons
 template<typename A, typename B, class Op> auto constexpr fold(A const a, vector<B,1> const& b, Op const& op) { return op(a, b.x); }
 template<typename A, typename B, class Op> auto constexpr fold(A const a, vector<B,2> const& b, Op const& op) { return op(op(a, b.x), b.y); }
 
-template<typename A, typename B> auto constexpr operator+(A const& a, B const& b) { return map(op_add, a, b); }
-template<typename A, typename B> auto constexpr operator-(A const& a, B const& b) { return map(op_sub, a, b); }
-template<typename A, typename B> auto constexpr operator*(A const& a, B const& b) { return map(op_mul, a, b); }
-template<typename A, typename B> auto constexpr operator/(A const& a, B const& b) { return map(op_div, a, b); }
-template<typename A, typename B> auto constexpr operator+=(A& a, B const& b) { return a = a + b; }
-template<typename A, typename B> auto constexpr operator-=(A& a, B const& b) { return a = a - b; }
-template<typename A, typename B> auto constexpr operator*=(A& a, B const& b) { return a = a * b; }
-template<typename A, typename B> auto constexpr operator/=(A& a, B const& b) { return a = a / b; }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator+(A const& a, B const& b) { return map(op_add, a, b); }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator-(A const& a, B const& b) { return map(op_sub, a, b); }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator*(A const& a, B const& b) { return map(op_mul, a, b); }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator/(A const& a, B const& b) { return map(op_div, a, b); }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator+=(A& a, B const& b) { return a = a + b; }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator-=(A& a, B const& b) { return a = a - b; }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator*=(A& a, B const& b) { return a = a * b; }
+template<typename A, typename B> requires vector_operands<A, B> auto constexpr operator/=(A& a, B const& b) { return a = a / b; }
 
 template<typename T> auto constexpr length_sq(vector<T,2> const& a) { return a.x * a.x + a.y * a.y; }
-template<typename T> auto constexpr length(vector<T,2> const& a) { return std::sqrt(length_sq(a)); }
+// Unqualified so fixed-point scalars find their own through ADL
+using std::sqrt;
+using std::abs;
+
+template<typename T> auto constexpr length(vector<T,2> const& a) { return sqrt(length_sq(a)); }
 template<typename T> auto constexpr normalize(vector<T,2> const& a) { return a / length(a); }
 
 template<typename T, class Op> auto constexpr sum(vector<T,2> const& a, Op const& op) { return op(a.x, a.y); }
@@ -0,0 +1,87 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "body_storage.h"
+
+namespace xc {
+
+template<class Storage, class F> auto static for_each_array(Storage& bodies, F&& f) -> void {
+    f(bodies.position_x); f(bodies.position_y);
+    f(bodies.velocity_x); f(bodies.velocity_y);
+    f(bodies.force_x); f(bodies.force_y);
+    f(bodies.rotation); f(bodies.angular_velocity); f(bodies.torque);
+    f(bodies.inverse_mass); f(bodies.inverse_inertia_tensor); f(bodies.damping);
+    f(bodies.radius); f(bodies.restitution); f(bodies.friction);
+    f(bodies.extent_x); f(bodies.extent_y); f(bodies.shape); f(bodies.polygon);
+}
+
+auto body_storage::size() const -> std::uint32_t {
+    return static_cast<std::uint32_t>(entity.size());
+}
+
+auto body_storage::push_back(entity_id const owner) -> std::uint32_t {
+    entity.push_back(owner);
+    for_each_array(*this, [](auto& array) { array.emplace_back(); });
+
+    return size() - 1;
+}
+
+auto body_storage::pop_back() -> void {
+    entity.pop_back();
+    for_each_array(*this, [](auto& array) { array.pop_back(); });
+}
+
+auto body_storage::swap(std::uint32_t const a, std::uint32_t const b) -> void {
+    std::swap(entity[a], entity[b]);
+    for_each_array(*this, [a, b](auto& array) { std::swap(array[a], array[b]); });
+}
+
+auto body_storage::load(std::uint32_t const slot, physics_body_component const& body) -> void {
+    position_x[slot] = body.position.x;
+    position_y[slot] = body.position.y;
+    velocity_x[slot] = body.velocity.x;
+    velocity_y[slot] = body.velocity.y;
+    force_x[slot] = body.force.x;
+    force_y[slot] = body.force.y;
+    rotation[slot] = body.rotation;
+    angular_velocity[slot] = body.angular_velocity;
+    torque[slot] = body.torque;
+    inverse_mass[slot] = body.inverse_mass;
+    inverse_inertia_tensor[slot] = body.inverse_inertia_tensor;
+    damping[slot] = body.damping;
+    radius[slot] = body.radius;
+    restitution[slot] = body.restitution;
+    friction[slot] = body.friction;
+    extent_x[slot] = body.extents.x;
+    extent_y[slot] = body.extents.y;
+    shape[slot] = body.shape;
+    polygon[slot] = body.polygon;
+}
+
+// Only the state the simulation changes goes back to the scene
+auto body_storage::store(std::uint32_t const slot, physics_body_component& body) const -> void {
+    body.previous_position = body.position;
+    body.previous_rotation = body.rotation;
+    body.position = {position_x[slot], position_y[slot]};
+    body.velocity = {velocity_x[slot], velocity_y[slot]};
+    body.force = {force_x[slot], force_y[slot]};
+    body.rotation = rotation[slot];
+    body.angular_velocity = angular_velocity[slot];
+    body.torque = torque[slot];
+}
+
+auto body_storage::save(snapshot_writer& writer) const -> void {
+    writer.write(entity);
+    for_each_array(*this, [&](auto const& array) { writer.write(array); });
+    writer.write(awake_count);
+    writer.write(dynamic_count);
+}
+
+auto body_storage::restore(snapshot_reader& reader) -> void {
+    reader.read(entity);
+    for_each_array(*this, [&](auto& array) { reader.read(array); });
+    reader.read(awake_count);
+    reader.read(dynamic_count);
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef ENGINE_PHYSICS_BODY_STORAGE_H
+#define ENGINE_PHYSICS_BODY_STORAGE_H
+
+#include <physics/types.h>
+#include <physics/snapshot.h>
+
+namespace xc {
+
+// Structure-of-arrays mirror of every physics_body_component. Slots are partitioned as
+// [awake | sleeping | static] so the kernels only ever walk a contiguous prefix.
+struct body_storage {
+    std::vector<entity_id> entity;
+
+    std::vector<real> position_x, position_y;
+    std::vector<real> velocity_x, velocity_y;
+    std::vector<real> force_x, force_y;
+    std::vector<real> rotation, angular_velocity, torque;
+    std::vector<real> inverse_mass, inverse_inertia_tensor, damping;
+    std::vector<real> radius, restitution, friction;
+    std::vector<real> extent_x, extent_y;
+    std::vector<shape_type> shape;
+    std::vector<std::uint32_t> polygon;
+
+    std::uint32_t awake_count = 0, dynamic_count = 0;
+
+    auto size() const -> std::uint32_t;
+
+    auto push_back(entity_id owner) -> std::uint32_t;
+    auto pop_back() -> void;
+    auto swap(std::uint32_t a, std::uint32_t b) -> void;
+
+    auto load(std::uint32_t slot, physics_body_component const& body) -> void;
+    auto store(std::uint32_t slot, physics_body_component& body) const -> void;
+
+    auto save(snapshot_writer& writer) const -> void;
+    auto restore(snapshot_reader& reader) -> void;
+
+    auto position(std::uint32_t slot) const -> real2 { return {position_x[slot], position_y[slot]}; }
+    auto velocity(std::uint32_t slot) const -> real2 { return {velocity_x[slot], velocity_y[slot]}; }
+};
+
+}
+
+#endif // ENGINE_PHYSICS_BODY_STORAGE_H
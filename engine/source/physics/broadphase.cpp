@@ -0,0 +1,22 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "broadphase.h"
+
+#include <physics/grid_broadphase.h>
+#include <physics/tree_broadphase.h>
+#include <physics/sweep_broadphase.h>
+
+namespace xc {
+
+auto broadphase::create(broadphase_type const type, float const cell_size, bool const pairs) -> std::shared_ptr<broadphase> {
+    switch (type) {
+        case broadphase_type::eGrid: return std::shared_ptr<grid_broadphase>{new grid_broadphase{cell_size}};
+        case broadphase_type::eTree: return std::shared_ptr<tree_broadphase>{new tree_broadphase{pairs}};
+        case broadphase_type::eSweep: return std::shared_ptr<sweep_broadphase>{new sweep_broadphase{}};
+    }
+
+    throw std::invalid_argument("unknown broadphase type");
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef ENGINE_PHYSICS_BROADPHASE_H
+#define ENGINE_PHYSICS_BROADPHASE_H
+
+#include <physics/types.h>
+#include <physics/snapshot.h>
+
+namespace xc {
+
+enum class broadphase_type { eGrid, eTree, eSweep };
+
+class broadphase {
+public:
+    // One that is only ever queried can be created without `pairs`, which spares it keeping the record of
+    // moved proxies that update_pairs works from
+    auto static create(broadphase_type type, float cell_size, bool pairs = true) -> std::shared_ptr<broadphase>;
+
+    virtual ~broadphase() = default;
+
+    virtual auto create_proxy(aabb const& bounds, entity_id entity) -> proxy_id = 0;
+    virtual auto destroy_proxy(proxy_id proxy) -> void = 0;
+    virtual auto move_proxy(proxy_id proxy, aabb const& bounds, vector2 const& displacement) -> void = 0;
+
+    virtual auto update_pairs(std::vector<body_pair>& pairs) -> void = 0;
+
+    // Appends every entity whose proxy bounds overlap `bounds`
+    virtual auto query(aabb const& bounds, std::vector<entity_id>& entities) -> void = 0;
+
+    // Appends every entity whose proxy bounds the segment from `from` to `to` passes through
+    virtual auto query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void = 0;
+
+    // Everything needed to carry on exactly as before, including pairs found so far and pending moves
+    virtual auto save(snapshot_writer& writer) const -> void = 0;
+    virtual auto restore(snapshot_reader& reader) -> void = 0;
+};
+
+}
+
+#endif // ENGINE_PHYSICS_BROADPHASE_H
@@ -0,0 +1,334 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "contact_solver.h"
+
+#include <physics/simd.h>
+
+#include <bit>
+#include <algorithm>
+
+namespace xc {
+
+auto static constexpr BAUMGARTE = real{0.2f};
+auto static constexpr PENETRATION_SLOP = real{0.5f};        // pixels
+auto static constexpr RESTITUTION_THRESHOLD = real{30};     // pixels per second
+
+// One bit per color in each body's mask; constraints that find every color taken overflow to a serial batch
+auto static constexpr GRAPH_COLORS = std::uint32_t{32};
+auto static constexpr OVERFLOW_COLOR = GRAPH_COLORS;
+
+auto static constexpr SOLVER_CHUNK_SIZE = std::size_t{256};
+
+auto static constexpr pair_key(body_pair const& pair) -> std::uint64_t {
+    return static_cast<std::uint64_t>(pair.a) << 32 | static_cast<std::uint32_t>(pair.b);
+}
+
+auto contact_solver::velocity_at(body_storage const& bodies, std::uint32_t const slot, real2 const& r) -> real2 {
+    if (slot == WORLD_SLOT) return {real{0}, real{0}};
+    return bodies.velocity(slot) + real2{-bodies.angular_velocity[slot] * r.y, bodies.angular_velocity[slot] * r.x};
+}
+
+auto contact_solver::add_contact(contact const& contact, std::uint32_t const slot_a, std::uint32_t const slot_b, body_storage const& bodies) -> void {
+    auto constraint = contact_solver::constraint{};
+
+    constraint.key = pair_key(contact.pair);
+    constraint.slot_a = slot_a;
+    constraint.slot_b = slot_b;
+    constraint.normal = contact.normal;
+    constraint.tangent = {-contact.normal.y, contact.normal.x};
+    constraint.r_a = contact.point - bodies.position(slot_a);
+
+    // The world is immovable and takes the body's own friction and restitution
+    auto const is_world = slot_b == WORLD_SLOT;
+    constraint.r_b = is_world ? real2{real{0}, real{0}} : contact.point - bodies.position(slot_b);
+    constraint.friction = is_world ? bodies.friction[slot_a] : sqrt(bodies.friction[slot_a] * bodies.friction[slot_b]);
+
+    auto const inverse_mass = bodies.inverse_mass[slot_a] + (is_world ? real{0} : bodies.inverse_mass[slot_b]);
+    auto const inverse_inertia_a = bodies.inverse_inertia_tensor[slot_a];
+    auto const inverse_inertia_b = is_world ? real{0} : bodies.inverse_inertia_tensor[slot_b];
+
+    auto const rn_a = cross(constraint.r_a, constraint.normal);
+    auto const rn_b = cross(constraint.r_b, constraint.normal);
+    auto const normal_mass = inverse_mass + inverse_inertia_a * rn_a * rn_a + inverse_inertia_b * rn_b * rn_b;
+    constraint.normal_mass = normal_mass > real{0} ? real{1} / normal_mass : real{0};
+
+    auto const rt_a = cross(constraint.r_a, constraint.tangent);
+    auto const rt_b = cross(constraint.r_b, constraint.tangent);
+    auto const tangent_mass = inverse_mass + inverse_inertia_a * rt_a * rt_a + inverse_inertia_b * rt_b * rt_b;
+    constraint.tangent_mass = tangent_mass > real{0} ? real{1} / tangent_mass : real{0};
+
+    // Bounce off the approach velocity as it was before any impulses this step
+    auto const relative_velocity = dot(velocity_at(bodies, slot_b, constraint.r_b) - velocity_at(bodies, slot_a, constraint.r_a), constraint.normal);
+    auto const restitution = is_world ? bodies.restitution[slot_a] : std::max(bodies.restitution[slot_a], bodies.restitution[slot_b]);
+    if (relative_velocity < -RESTITUTION_THRESHOLD) constraint.restitution_bias = -restitution * relative_velocity;
+
+    constraint.penetration = contact.penetration;
+
+    // Warm start from last step's impulses for the same pair
+    while (_cache_cursor < _cache.size() && _cache[_cache_cursor].key < constraint.key) ++_cache_cursor;
+    if (_cache_cursor < _cache.size() && _cache[_cache_cursor].key == constraint.key) {
+        constraint.normal_impulse = _cache[_cache_cursor].normal_impulse;
+        constraint.tangent_impulse = _cache[_cache_cursor].tangent_impulse;
+    }
+
+    _constraints.push_back(constraint);
+}
+
+auto contact_solver::solve(body_storage& bodies, real const step, int const iterations, thread_pool& workers) -> void {
+    auto const inverse_step = step > real{0} ? real{1} / step : real{0};
+
+    // Every body in a contact was woken before solving, so only the awake prefix can move
+    auto const body_count = bodies.awake_count;
+    auto const load = [body_count](std::vector<real>& working, std::vector<real> const& source) {
+        working.assign(source.begin(), source.begin() + body_count);
+        working.push_back(real{0});
+    };
+
+    load(_velocity_x, bodies.velocity_x);
+    load(_velocity_y, bodies.velocity_y);
+    load(_angular_velocity, bodies.angular_velocity);
+    load(_inverse_mass, bodies.inverse_mass);
+    load(_inverse_inertia, bodies.inverse_inertia_tensor);
+
+    for (auto& constraint : _constraints) {
+        // Push overlapping bodies apart over a few steps, unless they are already bouncing apart faster
+        auto const position_bias = BAUMGARTE * inverse_step * std::max(constraint.penetration - PENETRATION_SLOP, real{0});
+        constraint.velocity_bias = std::max(constraint.restitution_bias, position_bias);
+    }
+
+    color_constraints(body_count);
+
+    // Warm starting adds each constraint's impulse once, so it runs in a fixed order on this thread
+    auto const fixed_body = body_count;
+    for (auto i = std::size_t{0}; i < _order.size(); ++i) {
+        auto const a = _body_a[i], b = _body_b[i];
+        auto const impulse = real2{_normal_x[i], _normal_y[i]} * _normal_impulse[i] + real2{-_normal_y[i], _normal_x[i]} * _tangent_impulse[i];
+
+        if (a != fixed_body) {
+            _velocity_x[a] -= impulse.x * _inverse_mass[a];
+            _velocity_y[a] -= impulse.y * _inverse_mass[a];
+            _angular_velocity[a] -= _inverse_inertia[a] * cross(real2{_r_a_x[i], _r_a_y[i]}, impulse);
+        }
+        if (b != fixed_body) {
+            _velocity_x[b] += impulse.x * _inverse_mass[b];
+            _velocity_y[b] += impulse.y * _inverse_mass[b];
+            _angular_velocity[b] += _inverse_inertia[b] * cross(real2{_r_b_x[i], _r_b_y[i]}, impulse);
+        }
+    }
+
+    for (auto iteration = 0; iteration < iterations; ++iteration) {
+        for (auto color = std::uint32_t{0}; color < GRAPH_COLORS; ++color)
+            solve_color(_color_begin[color], _color_begin[color + 1], workers);
+
+        // Overflow constraints can share bodies with each other, so they never go through the lanes
+        solve_serial(_color_begin[OVERFLOW_COLOR], _color_begin[OVERFLOW_COLOR + 1]);
+    }
+
+    for (auto i = std::size_t{0}; i < _order.size(); ++i) {
+        _constraints[_order[i]].normal_impulse = _normal_impulse[i];
+        _constraints[_order[i]].tangent_impulse = _tangent_impulse[i];
+    }
+
+    std::copy_n(_velocity_x.begin(), body_count, bodies.velocity_x.begin());
+    std::copy_n(_velocity_y.begin(), body_count, bodies.velocity_y.begin());
+    std::copy_n(_angular_velocity.begin(), body_count, bodies.angular_velocity.begin());
+
+    // Constraints were added in key order, so the new cache comes out sorted
+    _cache.clear();
+    for (auto const& constraint : _constraints)
+        _cache.push_back({constraint.key, constraint.normal_impulse, constraint.tangent_impulse});
+
+    _constraints.clear();
+    _cache_cursor = 0;
+}
+
+auto contact_solver::color_constraints(std::uint32_t const body_count) -> void {
+    auto const count = _constraints.size();
+    auto const body_of = [body_count](std::uint32_t const slot) { return slot < body_count ? slot : body_count; };
+
+    // Greedy coloring in constraint order: each takes the lowest color neither of its moving bodies has yet
+    _body_colors.assign(body_count + 1, 0);
+    _constraint_colors.resize(count);
+    _color_begin.assign(GRAPH_COLORS + 2, 0);
+
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        auto const a = body_of(_constraints[i].slot_a);
+        auto const b = body_of(_constraints[i].slot_b);
+
+        auto const used = (a != body_count ? _body_colors[a] : 0u) | (b != body_count ? _body_colors[b] : 0u);
+        auto const color = used == ~std::uint32_t{0} ? OVERFLOW_COLOR : static_cast<std::uint32_t>(std::countr_one(used));
+
+        if (color != OVERFLOW_COLOR) {
+            if (a != body_count) _body_colors[a] |= 1u << color;
+            if (b != body_count) _body_colors[b] |= 1u << color;
+        }
+
+        _constraint_colors[i] = color;
+        ++_color_begin[color + 1];
+    }
+
+    for (auto color = std::uint32_t{0}; color <= OVERFLOW_COLOR; ++color)
+        _color_begin[color + 1] += _color_begin[color];
+
+    // Counting sort into color order, keeping constraint order within each color
+    for (auto array : {&_order, &_body_a, &_body_b}) array->resize(count);
+    for (auto array : {&_normal_x, &_normal_y, &_r_a_x, &_r_a_y, &_r_b_x, &_r_b_y, &_normal_mass, &_tangent_mass,
+                       &_normal_impulse, &_tangent_impulse, &_velocity_bias, &_friction}) array->resize(count);
+
+    _body_colors.assign(GRAPH_COLORS + 1, 0); // reused as each color's write cursor
+    for (auto i = std::size_t{0}; i < count; ++i) {
+        auto const color = _constraint_colors[i];
+        auto const index = _color_begin[color] + _body_colors[color]++;
+        auto const& constraint = _constraints[i];
+
+        _order[index] = static_cast<std::uint32_t>(i);
+        _body_a[index] = body_of(constraint.slot_a);
+        _body_b[index] = body_of(constraint.slot_b);
+        _normal_x[index] = constraint.normal.x;
+        _normal_y[index] = constraint.normal.y;
+        _r_a_x[index] = constraint.r_a.x;
+        _r_a_y[index] = constraint.r_a.y;
+        _r_b_x[index] = constraint.r_b.x;
+        _r_b_y[index] = constraint.r_b.y;
+        _normal_mass[index] = constraint.normal_mass;
+        _tangent_mass[index] = constraint.tangent_mass;
+        _normal_impulse[index] = constraint.normal_impulse;
+        _tangent_impulse[index] = constraint.tangent_impulse;
+        _velocity_bias[index] = constraint.velocity_bias;
+        _friction[index] = constraint.friction;
+    }
+}
+
+auto contact_solver::solve_color(std::size_t const begin, std::size_t const end, thread_pool& workers) -> void {
+    auto const range = std::pair{begin, end};
+    auto const chunk_count = (end - begin + SOLVER_CHUNK_SIZE - 1) / SOLVER_CHUNK_SIZE;
+
+    workers.run(chunk_count, [this, &range](std::size_t const chunk) {
+        auto const chunk_begin = range.first + chunk * SOLVER_CHUNK_SIZE;
+        solve_range(chunk_begin, std::min(chunk_begin + SOLVER_CHUNK_SIZE, range.second));
+    });
+}
+
+auto contact_solver::solve_range(std::size_t const begin, std::size_t const end) -> void {
+    auto i = begin;
+
+#ifdef PHYSICS_SIMD
+    auto const fixed_body = static_cast<std::uint32_t>(_inverse_mass.size() - 1);
+
+    alignas(32) float velocity_ax[LANE_WIDTH], velocity_ay[LANE_WIDTH], angular_a[LANE_WIDTH];
+    alignas(32) float velocity_bx[LANE_WIDTH], velocity_by[LANE_WIDTH], angular_b[LANE_WIDTH];
+
+    auto const zero = lane_set(0.f);
+
+    for (; i + LANE_WIDTH <= end; i += LANE_WIDTH) {
+        auto const* body_a = &_body_a[i];
+        auto const* body_b = &_body_b[i];
+
+        auto va_x = lane_gather(_velocity_x.data(), body_a), va_y = lane_gather(_velocity_y.data(), body_a);
+        auto wa = lane_gather(_angular_velocity.data(), body_a);
+        auto vb_x = lane_gather(_velocity_x.data(), body_b), vb_y = lane_gather(_velocity_y.data(), body_b);
+        auto wb = lane_gather(_angular_velocity.data(), body_b);
+
+        auto const mass_a = lane_gather(_inverse_mass.data(), body_a), inertia_a = lane_gather(_inverse_inertia.data(), body_a);
+        auto const mass_b = lane_gather(_inverse_mass.data(), body_b), inertia_b = lane_gather(_inverse_inertia.data(), body_b);
+
+        auto const n_x = lane_load(&_normal_x[i]), n_y = lane_load(&_normal_y[i]);
+        auto const ra_x = lane_load(&_r_a_x[i]), ra_y = lane_load(&_r_a_y[i]);
+        auto const rb_x = lane_load(&_r_b_x[i]), rb_y = lane_load(&_r_b_y[i]);
+
+        auto const relative_x = [&] { return lane_sub(lane_sub(vb_x, lane_mul(wb, rb_y)), lane_sub(va_x, lane_mul(wa, ra_y))); };
+        auto const relative_y = [&] { return lane_sub(lane_add(vb_y, lane_mul(wb, rb_x)), lane_add(va_y, lane_mul(wa, ra_x))); };
+
+        auto const apply = [&](lane const p_x, lane const p_y) {
+            va_x = lane_sub(va_x, lane_mul(p_x, mass_a));
+            va_y = lane_sub(va_y, lane_mul(p_y, mass_a));
+            wa = lane_sub(wa, lane_mul(inertia_a, lane_sub(lane_mul(ra_x, p_y), lane_mul(ra_y, p_x))));
+            vb_x = lane_add(vb_x, lane_mul(p_x, mass_b));
+            vb_y = lane_add(vb_y, lane_mul(p_y, mass_b));
+            wb = lane_add(wb, lane_mul(inertia_b, lane_sub(lane_mul(rb_x, p_y), lane_mul(rb_y, p_x))));
+        };
+
+        // Friction along the tangent (-n.y, n.x), bounded by the current normal impulse
+        auto const tangent_velocity = lane_add(lane_mul(relative_x(), lane_sub(zero, n_y)), lane_mul(relative_y(), n_x));
+        auto const max_friction = lane_mul(lane_load(&_friction[i]), lane_load(&_normal_impulse[i]));
+        auto const old_tangent = lane_load(&_tangent_impulse[i]);
+        auto const new_tangent = lane_min(lane_max(lane_sub(old_tangent, lane_mul(lane_load(&_tangent_mass[i]), tangent_velocity)),
+                                                   lane_sub(zero, max_friction)), max_friction);
+        auto const tangent_delta = lane_sub(new_tangent, old_tangent);
+        apply(lane_mul(lane_sub(zero, n_y), tangent_delta), lane_mul(n_x, tangent_delta));
+        lane_store(&_tangent_impulse[i], new_tangent);
+
+        // Non-penetration, accumulated impulse clamped to push only
+        auto const normal_velocity = lane_add(lane_mul(relative_x(), n_x), lane_mul(relative_y(), n_y));
+        auto const old_normal = lane_load(&_normal_impulse[i]);
+        auto const new_normal = lane_max(lane_sub(old_normal, lane_mul(lane_load(&_normal_mass[i]),
+                                                                       lane_sub(normal_velocity, lane_load(&_velocity_bias[i])))), zero);
+        auto const normal_delta = lane_sub(new_normal, old_normal);
+        apply(lane_mul(n_x, normal_delta), lane_mul(n_y, normal_delta));
+        lane_store(&_normal_impulse[i], new_normal);
+
+        // No two lanes share a moving body, so scattering back can't collide
+        lane_store(velocity_ax, va_x); lane_store(velocity_ay, va_y); lane_store(angular_a, wa);
+        lane_store(velocity_bx, vb_x); lane_store(velocity_by, vb_y); lane_store(angular_b, wb);
+
+        for (auto lane_index = std::uint32_t{0}; lane_index < LANE_WIDTH; ++lane_index) {
+            if (auto const a = body_a[lane_index]; a != fixed_body) {
+                _velocity_x[a] = velocity_ax[lane_index];
+                _velocity_y[a] = velocity_ay[lane_index];
+                _angular_velocity[a] = angular_a[lane_index];
+            }
+            if (auto const b = body_b[lane_index]; b != fixed_body) {
+                _velocity_x[b] = velocity_bx[lane_index];
+                _velocity_y[b] = velocity_by[lane_index];
+                _angular_velocity[b] = angular_b[lane_index];
+            }
+        }
+    }
+#endif
+
+    solve_serial(i, end);
+}
+
+auto contact_solver::solve_serial(std::size_t const begin, std::size_t const end) -> void {
+    auto const fixed_body = static_cast<std::uint32_t>(_inverse_mass.size() - 1);
+
+    for (auto i = begin; i < end; ++i) {
+        auto const a = _body_a[i], b = _body_b[i];
+        auto const normal = real2{_normal_x[i], _normal_y[i]};
+        auto const tangent = real2{-normal.y, normal.x};
+        auto const r_a = real2{_r_a_x[i], _r_a_y[i]};
+        auto const r_b = real2{_r_b_x[i], _r_b_y[i]};
+
+        auto const relative_velocity = [&] {
+            return real2{(_velocity_x[b] - _angular_velocity[b] * r_b.y) - (_velocity_x[a] - _angular_velocity[a] * r_a.y),
+                         (_velocity_y[b] + _angular_velocity[b] * r_b.x) - (_velocity_y[a] + _angular_velocity[a] * r_a.x)};
+        };
+
+        auto const apply = [&](real2 const& impulse) {
+            if (a != fixed_body) {
+                _velocity_x[a] -= impulse.x * _inverse_mass[a];
+                _velocity_y[a] -= impulse.y * _inverse_mass[a];
+                _angular_velocity[a] -= _inverse_inertia[a] * cross(r_a, impulse);
+            }
+            if (b != fixed_body) {
+                _velocity_x[b] += impulse.x * _inverse_mass[b];
+                _velocity_y[b] += impulse.y * _inverse_mass[b];
+                _angular_velocity[b] += _inverse_inertia[b] * cross(r_b, impulse);
+            }
+        };
+
+        // Friction, bounded by the current normal impulse
+        auto const max_friction = _friction[i] * _normal_impulse[i];
+        auto const old_tangent_impulse = _tangent_impulse[i];
+        _tangent_impulse[i] = std::clamp(old_tangent_impulse - _tangent_mass[i] * dot(relative_velocity(), tangent), -max_friction, max_friction);
+        apply(tangent * (_tangent_impulse[i] - old_tangent_impulse));
+
+        // Non-penetration, accumulated impulse clamped to push only
+        auto const old_normal_impulse = _normal_impulse[i];
+        _normal_impulse[i] = std::max(old_normal_impulse - _normal_mass[i] * (dot(relative_velocity(), normal) - _velocity_bias[i]), real{0});
+        apply(normal * (_normal_impulse[i] - old_normal_impulse));
+    }
+}
+
+}
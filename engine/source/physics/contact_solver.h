@@ -0,0 +1,69 @@
+#ifndef ENGINE_PHYSICS_CONTACT_SOLVER_H
+#define ENGINE_PHYSICS_CONTACT_SOLVER_H
+
+#include <physics/body_storage.h>
+#include <core/thread_pool.h>
+
+namespace xc {
+
+// Sequential impulse solver. Accumulated impulses are cached per body pair and applied up front on the
+// next step, so resting contacts start close to their solution and need only a few iterations.
+//
+// Constraints are graph colored so that no two of the same color share a moving body. Each color is then
+// solved LANE_WIDTH constraints at a time and spread over the workers, and since nothing within a color
+// depends on the order it is solved in, the result is the same for any thread count.
+class contact_solver {
+public:
+    // Stands in for slot_b when a body touches static level geometry that has no body of its own
+    auto static constexpr WORLD_SLOT = ~std::uint32_t{0};
+
+    // Contacts must be added in ascending pair order, which lets the cache be matched in a single pass
+    auto add_contact(contact const& contact, std::uint32_t slot_a, std::uint32_t slot_b, body_storage const& bodies) -> void;
+
+    auto solve(body_storage& bodies, real step, int iterations, thread_pool& workers) -> void;
+
+    // Only the impulse cache outlives a step
+    auto save(snapshot_writer& writer) const -> void { writer.write(_cache); }
+    auto restore(snapshot_reader& reader) -> void { reader.read(_cache); }
+
+private:
+    struct constraint {
+        std::uint64_t key;
+        std::uint32_t slot_a, slot_b;
+        real2 normal, tangent, r_a, r_b;
+        real normal_mass, tangent_mass;
+        real normal_impulse, tangent_impulse;
+        real penetration, restitution_bias, velocity_bias, friction;
+    };
+
+    struct cached_impulse {
+        std::uint64_t key;
+        real normal_impulse, tangent_impulse;
+    };
+
+    auto static velocity_at(body_storage const& bodies, std::uint32_t slot, real2 const& r) -> real2;
+
+    auto color_constraints(std::uint32_t body_count) -> void;
+    auto solve_range(std::size_t begin, std::size_t end) -> void;
+    auto solve_serial(std::size_t begin, std::size_t end) -> void;
+    auto solve_color(std::size_t begin, std::size_t end, thread_pool& workers) -> void;
+
+    std::vector<constraint> _constraints;
+    std::vector<cached_impulse> _cache;
+    std::size_t _cache_cursor = 0;
+
+    // Awake bodies' velocities while solving, plus one last entry standing in for anything that doesn't
+    // move: static bodies and the world. Nothing is ever written to it.
+    std::vector<real> _velocity_x, _velocity_y, _angular_velocity, _inverse_mass, _inverse_inertia;
+
+    // Constraints regrouped by color, structure of arrays. Colors occupy [_color_begin[c], _color_begin[c + 1]);
+    // the last range holds whatever couldn't be colored and is solved on one thread.
+    std::vector<std::uint32_t> _body_colors, _constraint_colors, _order, _color_begin;
+    std::vector<std::uint32_t> _body_a, _body_b;
+    std::vector<real> _normal_x, _normal_y, _r_a_x, _r_a_y, _r_b_x, _r_b_y;
+    std::vector<real> _normal_mass, _tangent_mass, _normal_impulse, _tangent_impulse, _velocity_bias, _friction;
+};
+
+}
+
+#endif // ENGINE_PHYSICS_CONTACT_SOLVER_H
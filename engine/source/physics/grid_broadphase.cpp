@@ -0,0 +1,228 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "grid_broadphase.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace xc {
+
+auto static constexpr pack_cell(std::int32_t x, std::int32_t y) -> std::uint64_t {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(y);
+}
+
+grid_broadphase::grid_broadphase(float const cell_size)
+    : _cell_size{cell_size}, _inverse_cell_size{1.f / cell_size} {}
+
+auto grid_broadphase::create_proxy(aabb const& bounds, entity_id const entity) -> proxy_id {
+    if (!_free_proxies.empty()) {
+        auto proxy = _free_proxies.back();
+        _free_proxies.pop_back();
+        _proxies[proxy] = {bounds, entity, true};
+        _dirty = true;
+        return proxy;
+    }
+
+    _proxies.push_back({bounds, entity, true});
+    _dirty = true;
+    return static_cast<proxy_id>(_proxies.size() - 1);
+}
+
+auto grid_broadphase::destroy_proxy(proxy_id const proxy) -> void {
+    _proxies[proxy].in_use = false;
+    _free_proxies.push_back(proxy);
+    _dirty = true;
+}
+
+auto grid_broadphase::move_proxy(proxy_id const proxy, aabb const& bounds, vector2 const&) -> void {
+    _proxies[proxy].bounds = bounds;
+    _dirty = true;
+}
+
+auto grid_broadphase::cell_key(float const x, float const y) const -> std::uint64_t {
+    return pack_cell(static_cast<std::int32_t>(std::floor(x * _inverse_cell_size)),
+                     static_cast<std::int32_t>(std::floor(y * _inverse_cell_size)));
+}
+
+auto grid_broadphase::rebuild() -> void {
+    _cell_entries.clear();
+    _min_cell_x = _min_cell_y = std::numeric_limits<std::int32_t>::max();
+    _max_cell_x = _max_cell_y = std::numeric_limits<std::int32_t>::min();
+
+    // Bin every proxy into each cell its bounds touch
+    for (auto i = proxy_id{0}; i < _proxies.size(); ++i) {
+        auto const& proxy = _proxies[i];
+        if (!proxy.in_use) continue;
+
+        auto const min_x = static_cast<std::int32_t>(std::floor(proxy.bounds.min.x * _inverse_cell_size));
+        auto const min_y = static_cast<std::int32_t>(std::floor(proxy.bounds.min.y * _inverse_cell_size));
+        auto const max_x = static_cast<std::int32_t>(std::floor(proxy.bounds.max.x * _inverse_cell_size));
+        auto const max_y = static_cast<std::int32_t>(std::floor(proxy.bounds.max.y * _inverse_cell_size));
+
+        for (auto y = min_y; y <= max_y; ++y)
+            for (auto x = min_x; x <= max_x; ++x)
+                _cell_entries.push_back({pack_cell(x, y), i});
+
+        _min_cell_x = std::min(_min_cell_x, min_x);
+        _min_cell_y = std::min(_min_cell_y, min_y);
+        _max_cell_x = std::max(_max_cell_x, max_x);
+        _max_cell_y = std::max(_max_cell_y, max_y);
+    }
+
+    std::sort(_cell_entries.begin(), _cell_entries.end(), [](auto const& a, auto const& b) {
+        return a.cell < b.cell || (a.cell == b.cell && a.proxy < b.proxy);
+    });
+
+    _dirty = false;
+}
+
+auto grid_broadphase::update_pairs(std::vector<body_pair>& pairs) -> void {
+    if (_dirty) rebuild();
+
+    // Test proxies sharing a cell. Two proxies can share several cells, so a pair is only reported
+    // from the cell holding the minimum corner of their overlap.
+    for (auto begin = std::size_t{0}; begin < _cell_entries.size();) {
+        auto const cell = _cell_entries[begin].cell;
+
+        auto end = begin + 1;
+        while (end < _cell_entries.size() && _cell_entries[end].cell == cell) ++end;
+
+        for (auto i = begin; i < end; ++i) {
+            auto const& proxy_a = _proxies[_cell_entries[i].proxy];
+
+            for (auto j = i + 1; j < end; ++j) {
+                auto const& proxy_b = _proxies[_cell_entries[j].proxy];
+                if (!overlaps(proxy_a.bounds, proxy_b.bounds)) continue;
+
+                auto const overlap_x = std::max(proxy_a.bounds.min.x, proxy_b.bounds.min.x);
+                auto const overlap_y = std::max(proxy_a.bounds.min.y, proxy_b.bounds.min.y);
+                if (cell_key(overlap_x, overlap_y) != cell) continue;
+
+                pairs.push_back({std::min(proxy_a.entity, proxy_b.entity), std::max(proxy_a.entity, proxy_b.entity)});
+            }
+        }
+
+        begin = end;
+    }
+}
+
+auto grid_broadphase::query(aabb const& bounds, std::vector<entity_id>& entities) -> void {
+    if (_dirty) rebuild();
+    if (_cell_entries.empty()) return;
+
+    // Cells the bounds cover, clamped to those holding any proxy before the cast so that huge or
+    // non-finite bounds stay in range. Nothing outside them can be reported anyway.
+    auto const clamp_cell = [this](float const coordinate, std::int32_t const low, std::int32_t const high) {
+        auto const cell = std::floor(coordinate * _inverse_cell_size);
+        if (!(cell > static_cast<float>(low))) return low;
+        return cell < static_cast<float>(high) ? static_cast<std::int32_t>(cell) : high;
+    };
+
+    auto const min_x = clamp_cell(bounds.min.x, _min_cell_x, _max_cell_x);
+    auto const min_y = clamp_cell(bounds.min.y, _min_cell_y, _max_cell_y);
+    auto const max_x = clamp_cell(bounds.max.x, _min_cell_x, _max_cell_x);
+    auto const max_y = clamp_cell(bounds.max.y, _min_cell_y, _max_cell_y);
+
+    auto const report = [&](cell_entry const& entry) {
+        auto const& proxy = _proxies[entry.proxy];
+        if (!overlaps(proxy.bounds, bounds)) return;
+
+        // Same rule as for pairs: report from the cell holding the minimum corner of the overlap
+        auto const overlap_x = std::max(proxy.bounds.min.x, bounds.min.x);
+        auto const overlap_y = std::max(proxy.bounds.min.y, bounds.min.y);
+        if (cell_key(overlap_x, overlap_y) != entry.cell) return;
+
+        entities.push_back(proxy.entity);
+    };
+
+    // A box covering more cells than there are entries is cheaper to answer with one pass over the entries
+    auto const cell_count = (std::int64_t{max_x} - min_x + 1) * (std::int64_t{max_y} - min_y + 1);
+    if (cell_count > static_cast<std::int64_t>(_cell_entries.size())) {
+        for (auto const& entry : _cell_entries) {
+            auto const x = static_cast<std::int32_t>(static_cast<std::uint32_t>(entry.cell >> 32));
+            auto const y = static_cast<std::int32_t>(static_cast<std::uint32_t>(entry.cell));
+            if (x >= min_x && x <= max_x && y >= min_y && y <= max_y) report(entry);
+        }
+        return;
+    }
+
+    for (auto y = min_y; y <= max_y; ++y) {
+        for (auto x = min_x; x <= max_x; ++x) {
+            auto const cell = pack_cell(x, y);
+            auto entry = std::lower_bound(_cell_entries.begin(), _cell_entries.end(), cell, [](auto const& a, auto const b) {
+                return a.cell < b;
+            });
+
+            for (; entry != _cell_entries.end() && entry->cell == cell; ++entry) report(*entry);
+        }
+    }
+}
+
+auto grid_broadphase::query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void {
+    if (_dirty) rebuild();
+
+    auto const first = entities.size();
+    auto const delta = to - from;
+
+    auto x = static_cast<std::int32_t>(std::floor(from.x * _inverse_cell_size));
+    auto y = static_cast<std::int32_t>(std::floor(from.y * _inverse_cell_size));
+    auto const end_x = static_cast<std::int32_t>(std::floor(to.x * _inverse_cell_size));
+    auto const end_y = static_cast<std::int32_t>(std::floor(to.y * _inverse_cell_size));
+
+    // Walk the cells the segment crosses, tracking how far along it the next x and y cell boundaries are
+    auto const step_x = delta.x < 0.f ? -1 : 1;
+    auto const step_y = delta.y < 0.f ? -1 : 1;
+    auto constexpr never = std::numeric_limits<float>::infinity();
+
+    auto const next_boundary = [this](std::int32_t const cell, std::int32_t const step, float const start, float const distance) {
+        if (distance == 0.f) return never;
+        auto const boundary = static_cast<float>(step > 0 ? cell + 1 : cell) * _cell_size;
+        return (boundary - start) / distance;
+    };
+
+    auto const delta_x = delta.x == 0.f ? never : _cell_size / std::abs(delta.x);
+    auto const delta_y = delta.y == 0.f ? never : _cell_size / std::abs(delta.y);
+    auto next_x = next_boundary(x, step_x, from.x, delta.x);
+    auto next_y = next_boundary(y, step_y, from.y, delta.y);
+
+    auto const cell_count = 1 + std::abs(end_x - x) + std::abs(end_y - y);
+    for (auto i = 0; i < cell_count; ++i) {
+        auto const cell = pack_cell(x, y);
+        auto entry = std::lower_bound(_cell_entries.begin(), _cell_entries.end(), cell, [](auto const& a, auto const b) {
+            return a.cell < b;
+        });
+
+        for (; entry != _cell_entries.end() && entry->cell == cell; ++entry) {
+            auto const& proxy = _proxies[entry->proxy];
+            if (overlaps(proxy.bounds, from, to)) entities.push_back(proxy.entity);
+        }
+
+        if (next_x < next_y) {
+            x += step_x;
+            next_x += delta_x;
+        } else {
+            y += step_y;
+            next_y += delta_y;
+        }
+    }
+
+    // Proxies spanning several crossed cells were found once per cell
+    auto const begin = entities.begin() + static_cast<std::ptrdiff_t>(first);
+    std::sort(begin, entities.end());
+    entities.erase(std::unique(begin, entities.end()), entities.end());
+}
+
+auto grid_broadphase::save(snapshot_writer& writer) const -> void {
+    writer.write(_proxies);
+    writer.write(_free_proxies);
+}
+
+// Cells are binned again from the proxies on the next query
+auto grid_broadphase::restore(snapshot_reader& reader) -> void {
+    reader.read(_proxies);
+    reader.read(_free_proxies);
+    _dirty = true;
+}
+
+}
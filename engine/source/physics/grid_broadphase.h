@@ -0,0 +1,54 @@
+#ifndef ENGINE_PHYSICS_GRID_BROADPHASE_H
+#define ENGINE_PHYSICS_GRID_BROADPHASE_H
+
+#include <physics/broadphase.h>
+
+namespace xc {
+
+// Uniform grid hashed on integer cell coordinates. Proxies are re-binned every update, which is
+// cheap for bodies no larger than a few cells; candidate pairs are reported once each.
+// Cells are rebuilt lazily, so a grid of proxies that never move is binned only once.
+class grid_broadphase final : public broadphase {
+    friend class broadphase;
+
+public:
+    auto create_proxy(aabb const& bounds, entity_id entity) -> proxy_id final;
+    auto destroy_proxy(proxy_id proxy) -> void final;
+    auto move_proxy(proxy_id proxy, aabb const& bounds, vector2 const& displacement) -> void final;
+
+    auto update_pairs(std::vector<body_pair>& pairs) -> void final;
+    auto query(aabb const& bounds, std::vector<entity_id>& entities) -> void final;
+    auto query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void final;
+
+    auto save(snapshot_writer& writer) const -> void final;
+    auto restore(snapshot_reader& reader) -> void final;
+
+private:
+    explicit grid_broadphase(float cell_size);
+
+    struct proxy {
+        aabb bounds;
+        entity_id entity;
+        bool in_use;
+    };
+
+    struct cell_entry {
+        std::uint64_t cell;
+        proxy_id proxy;
+    };
+
+    auto cell_key(float x, float y) const -> std::uint64_t;
+    auto rebuild() -> void;
+
+    float _cell_size, _inverse_cell_size;
+
+    std::vector<proxy> _proxies;
+    std::vector<proxy_id> _free_proxies;
+    std::vector<cell_entry> _cell_entries;
+    std::int32_t _min_cell_x = 0, _min_cell_y = 0, _max_cell_x = -1, _max_cell_y = -1; // cells holding any proxy
+    bool _dirty = true;
+};
+
+}
+
+#endif // ENGINE_PHYSICS_GRID_BROADPHASE_H
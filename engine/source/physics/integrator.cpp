@@ -0,0 +1,84 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "integrator.h"
+
+#include <physics/simd.h>
+
+namespace xc {
+
+auto integrate_forces(body_storage& bodies, std::uint32_t const count, real2 const& gravity, real const step) -> void {
+    auto i = std::uint32_t{0};
+
+#ifdef PHYSICS_SIMD
+    auto const gravity_x = lane_set(gravity.x);
+    auto const gravity_y = lane_set(gravity.y);
+    auto const dt = lane_set(step);
+
+    for (; i + LANE_WIDTH <= count; i += LANE_WIDTH) {
+        auto const inverse_mass = lane_load(&bodies.inverse_mass[i]);
+
+        auto const acceleration_x = lane_add(gravity_x, lane_mul(inverse_mass, lane_load(&bodies.force_x[i])));
+        auto const acceleration_y = lane_add(gravity_y, lane_mul(inverse_mass, lane_load(&bodies.force_y[i])));
+        lane_store(&bodies.velocity_x[i], lane_add(lane_load(&bodies.velocity_x[i]), lane_mul(acceleration_x, dt)));
+        lane_store(&bodies.velocity_y[i], lane_add(lane_load(&bodies.velocity_y[i]), lane_mul(acceleration_y, dt)));
+
+        auto const angular_acceleration = lane_mul(lane_load(&bodies.inverse_inertia_tensor[i]), lane_load(&bodies.torque[i]));
+        lane_store(&bodies.angular_velocity[i], lane_add(lane_load(&bodies.angular_velocity[i]), lane_mul(angular_acceleration, dt)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        bodies.velocity_x[i] += (gravity.x + bodies.inverse_mass[i] * bodies.force_x[i]) * step;
+        bodies.velocity_y[i] += (gravity.y + bodies.inverse_mass[i] * bodies.force_y[i]) * step;
+        bodies.angular_velocity[i] += bodies.inverse_inertia_tensor[i] * bodies.torque[i] * step;
+    }
+}
+
+auto integrate_velocities(body_storage& bodies, std::uint32_t const count, real const step) -> void {
+    auto i = std::uint32_t{0};
+
+#ifdef PHYSICS_SIMD
+    auto const dt = lane_set(step);
+    auto const zero = lane_set(0.f);
+    auto const one = lane_set(1.f);
+
+    for (; i + LANE_WIDTH <= count; i += LANE_WIDTH) {
+        auto const velocity_x = lane_load(&bodies.velocity_x[i]);
+        auto const velocity_y = lane_load(&bodies.velocity_y[i]);
+        auto const angular_velocity = lane_load(&bodies.angular_velocity[i]);
+
+        lane_store(&bodies.position_x[i], lane_add(lane_load(&bodies.position_x[i]), lane_mul(velocity_x, dt)));
+        lane_store(&bodies.position_y[i], lane_add(lane_load(&bodies.position_y[i]), lane_mul(velocity_y, dt)));
+        lane_store(&bodies.rotation[i], lane_add(lane_load(&bodies.rotation[i]), lane_mul(angular_velocity, dt)));
+
+        lane_store(&bodies.force_x[i], zero);
+        lane_store(&bodies.force_y[i], zero);
+        lane_store(&bodies.torque[i], zero);
+
+        // Apply damping
+        auto const damping = lane_div(one, lane_add(one, lane_mul(lane_load(&bodies.damping[i]), dt)));
+        lane_store(&bodies.velocity_x[i], lane_mul(velocity_x, damping));
+        lane_store(&bodies.velocity_y[i], lane_mul(velocity_y, damping));
+        lane_store(&bodies.angular_velocity[i], lane_mul(angular_velocity, damping));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        bodies.position_x[i] += bodies.velocity_x[i] * step;
+        bodies.position_y[i] += bodies.velocity_y[i] * step;
+        bodies.rotation[i] += bodies.angular_velocity[i] * step;
+
+        bodies.force_x[i] = real{0};
+        bodies.force_y[i] = real{0};
+        bodies.torque[i] = real{0};
+
+        // Apply damping
+        auto const damping = real{1} / (real{1} + bodies.damping[i] * step);
+        bodies.velocity_x[i] *= damping;
+        bodies.velocity_y[i] *= damping;
+        bodies.angular_velocity[i] *= damping;
+    }
+}
+
+}
@@ -0,0 +1,14 @@
+#ifndef ENGINE_PHYSICS_INTEGRATOR_H
+#define ENGINE_PHYSICS_INTEGRATOR_H
+
+#include <physics/body_storage.h>
+
+namespace xc {
+
+// Kernels over the first `count` slots, LANE_WIDTH bodies per iteration with a scalar loop for the remainder
+auto integrate_forces(body_storage& bodies, std::uint32_t count, real2 const& gravity, real step) -> void;
+auto integrate_velocities(body_storage& bodies, std::uint32_t count, real step) -> void;
+
+}
+
+#endif // ENGINE_PHYSICS_INTEGRATOR_H
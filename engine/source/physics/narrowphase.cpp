@@ -0,0 +1,209 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "narrowphase.h"
+
+#include <physics/simd.h>
+#include <physics/shapes.h>
+
+#include <algorithm>
+
+namespace xc {
+
+auto static collide_circle_circle(body_storage const& bodies, body_pair const& pair,
+                                  std::uint32_t const slot_a, std::uint32_t const slot_b, contact& result) -> bool {
+    auto const position_a = bodies.position(slot_a);
+    auto const delta = bodies.position(slot_b) - position_a;
+    auto const distance_sq = length_sq(delta);
+
+    auto const radius_a = bodies.radius[slot_a];
+    auto const radius = radius_a + bodies.radius[slot_b];
+    if (distance_sq >= radius * radius) return false;
+
+    auto const distance = sqrt(distance_sq);
+
+    result.pair = pair;
+    if (distance == real{0}) {
+        result.normal = real2{real{1}, real{0}};
+        result.penetration = radius;
+        result.point = position_a;
+    } else {
+        // Multiplying by the reciprocal, as the lanes do, so a pair gives the same contact either way
+        result.normal = delta * (real{1} / distance);
+        result.penetration = radius - distance;
+        result.point = result.normal * (radius_a - result.penetration * real{0.5f}) + position_a;
+    }
+
+    return true;
+}
+
+auto collide_circles(body_storage const& bodies, std::span<body_pair const> pairs,
+                     std::span<std::uint32_t const> slots_a, std::span<std::uint32_t const> slots_b,
+                     std::span<contact> contacts) -> std::size_t {
+    auto const count = pairs.size();
+    auto written = std::size_t{0};
+    auto i = std::size_t{0};
+
+#ifdef PHYSICS_SIMD
+    alignas(32) float normal_x[LANE_WIDTH], normal_y[LANE_WIDTH], point_x[LANE_WIDTH], point_y[LANE_WIDTH], penetration[LANE_WIDTH];
+
+    auto const zero = lane_set(0.f);
+    auto const one = lane_set(1.f);
+    auto const half = lane_set(0.5f);
+
+    for (; i + LANE_WIDTH <= count; i += LANE_WIDTH) {
+        auto const position_ax = lane_gather(bodies.position_x.data(), &slots_a[i]);
+        auto const position_ay = lane_gather(bodies.position_y.data(), &slots_a[i]);
+        auto const delta_x = lane_sub(lane_gather(bodies.position_x.data(), &slots_b[i]), position_ax);
+        auto const delta_y = lane_sub(lane_gather(bodies.position_y.data(), &slots_b[i]), position_ay);
+        auto const distance_sq = lane_add(lane_mul(delta_x, delta_x), lane_mul(delta_y, delta_y));
+
+        auto const radius_a = lane_gather(bodies.radius.data(), &slots_a[i]);
+        auto const radius = lane_add(radius_a, lane_gather(bodies.radius.data(), &slots_b[i]));
+
+        auto const hits = lane_mask_bits(lane_less(distance_sq, lane_mul(radius, radius)));
+        if (hits == 0) continue;
+
+        // Coincident centres get an arbitrary +x normal, as in the scalar path
+        auto const distance = lane_sqrt(distance_sq);
+        auto const separated = lane_less(zero, distance);
+        auto const inverse_distance = lane_select(separated, lane_div(one, distance), zero);
+        auto const nx = lane_select(separated, lane_mul(delta_x, inverse_distance), one);
+        auto const ny = lane_mul(delta_y, inverse_distance);
+        auto const depth = lane_sub(radius, distance);
+        auto const offset = lane_sub(radius_a, lane_mul(depth, half));
+
+        lane_store(normal_x, nx);
+        lane_store(normal_y, ny);
+        lane_store(penetration, depth);
+        lane_store(point_x, lane_select(separated, lane_add(position_ax, lane_mul(nx, offset)), position_ax));
+        lane_store(point_y, lane_select(separated, lane_add(position_ay, lane_mul(ny, offset)), position_ay));
+
+        for (auto lane_index = std::uint32_t{0}; lane_index < LANE_WIDTH; ++lane_index) {
+            if (!(hits & (1 << lane_index))) continue;
+
+            auto& result = contacts[written++];
+            result.pair = pairs[i + lane_index];
+            result.normal = vector2{normal_x[lane_index], normal_y[lane_index]};
+            result.point = vector2{point_x[lane_index], point_y[lane_index]};
+            result.penetration = penetration[lane_index];
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+        if (collide_circle_circle(bodies, pairs[i], slots_a[i], slots_b[i], contacts[written])) ++written;
+
+    return written;
+}
+
+auto collide_bodies(body_storage const& bodies, std::span<convex_polygon const> polygons, std::span<body_pair const> pairs,
+                    std::span<std::uint32_t const> slots_a, std::span<std::uint32_t const> slots_b,
+                    std::span<contact> contacts) -> std::size_t {
+    auto const count = pairs.size();
+    auto const is_circle = [&](std::size_t const i) {
+        return bodies.shape[slots_a[i]] == shape_type::eCircle && bodies.shape[slots_b[i]] == shape_type::eCircle;
+    };
+
+    // Contacts are never written ahead of the pair being tested, so each run can write into the same buffer
+    auto written = std::size_t{0};
+    for (auto i = std::size_t{0}; i < count;) {
+        auto end = i;
+        while (end < count && is_circle(end)) ++end;
+
+        if (end > i) {
+            written += collide_circles(bodies, pairs.subspan(i, end - i), slots_a.subspan(i, end - i),
+                                       slots_b.subspan(i, end - i), contacts.subspan(written, end - i));
+            i = end;
+            continue;
+        }
+
+        auto& result = contacts[written];
+        if (collide_shapes(shape_of(bodies, polygons, slots_a[i]), shape_of(bodies, polygons, slots_b[i]), result)) {
+            result.pair = pairs[i];
+            ++written;
+        }
+        ++i;
+    }
+
+    return written;
+}
+
+auto time_of_impact(real2 const& start, real2 const& displacement, real const radius,
+                    real2 const& center, real const other_radius) -> real {
+    auto constexpr miss = real{2};
+
+    // Solve |start - center + t * displacement| = radius + other_radius for the smaller root
+    auto const offset = start - center;
+    auto const a = dot(displacement, displacement);
+    auto const b = dot(offset, displacement);
+    auto const c = dot(offset, offset) - (radius + other_radius) * (radius + other_radius);
+    if (c < real{0} || b >= real{0} || a == real{0}) return miss;
+
+    auto const discriminant = b * b - a * c;
+    if (discriminant < real{0}) return miss;
+
+    return (-b - sqrt(discriminant)) / a;
+}
+
+auto collide_circle_box(real2 const& center, real const radius, real2 const& min, real2 const& max, contact& result) -> bool {
+    auto const closest = real2{std::clamp(center.x, min.x, max.x), std::clamp(center.y, min.y, max.y)};
+    auto const delta = closest - center;
+    auto const distance_sq = length_sq(delta);
+    if (distance_sq >= radius * radius) return false;
+
+    if (distance_sq == real{0}) {
+        // Centre inside the box: push out through the nearest face
+        auto const left = center.x - min.x, right = max.x - center.x;
+        auto const top = center.y - min.y, bottom = max.y - center.y;
+        auto const depth = std::min(std::min(left, right), std::min(top, bottom));
+
+        if (depth == left) result.normal = real2{real{1}, real{0}};
+        else if (depth == right) result.normal = real2{real{-1}, real{0}};
+        else if (depth == top) result.normal = real2{real{0}, real{1}};
+        else result.normal = real2{real{0}, real{-1}};
+
+        result.penetration = depth + radius;
+        result.point = center;
+        return true;
+    }
+
+    auto const distance = sqrt(distance_sq);
+    result.normal = delta / distance;
+    result.penetration = radius - distance;
+    result.point = result.normal * (radius - result.penetration * real{0.5f}) + center;
+    return true;
+}
+
+auto time_of_impact(real2 const& start, real2 const& displacement, real const radius,
+                    real2 const& min, real2 const& max) -> real {
+    auto constexpr miss = real{2};
+
+    auto const closest = real2{std::clamp(start.x, min.x, max.x), std::clamp(start.y, min.y, max.y)};
+    if (length_sq(start - closest) < radius * radius) return miss;
+
+    // Ray against the box grown by the radius, then against the rounded corner if it enters beside one
+    auto enter = real{0}, exit = real{1};
+    auto const slab = [&](real const origin, real const delta, real const low, real const high) {
+        if (delta == real{0}) return origin >= low && origin <= high;
+
+        auto t0 = (low - origin) / delta, t1 = (high - origin) / delta;
+        if (t0 > t1) std::swap(t0, t1);
+        enter = std::max(enter, t0);
+        exit = std::min(exit, t1);
+        return enter <= exit;
+    };
+
+    if (!slab(start.x, displacement.x, min.x - radius, max.x + radius)) return miss;
+    if (!slab(start.y, displacement.y, min.y - radius, max.y + radius)) return miss;
+
+    auto const point = start + displacement * enter;
+    auto const beside_x = point.x < min.x || point.x > max.x;
+    auto const beside_y = point.y < min.y || point.y > max.y;
+    if (!beside_x || !beside_y) return enter;
+
+    auto const corner = real2{std::clamp(point.x, min.x, max.x), std::clamp(point.y, min.y, max.y)};
+    return time_of_impact(start, displacement, radius, corner, real{0});
+}
+
+}
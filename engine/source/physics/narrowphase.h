@@ -0,0 +1,36 @@
+#ifndef ENGINE_PHYSICS_NARROWPHASE_H
+#define ENGINE_PHYSICS_NARROWPHASE_H
+
+#include <physics/body_storage.h>
+
+#include <span>
+
+namespace xc {
+
+// Tests pairs[i] using the bodies at slots_a[i] and slots_b[i], LANE_WIDTH pairs at a time. Touching pairs
+// are written to the front of `contacts`, which must have room for every pair; returns how many were written.
+auto collide_circles(body_storage const& bodies, std::span<body_pair const> pairs,
+                     std::span<std::uint32_t const> slots_a, std::span<std::uint32_t const> slots_b,
+                     std::span<contact> contacts) -> std::size_t;
+
+// As above for any mix of shapes. Runs of circle pairs still go through the lanes; every other pair is
+// dispatched on its two shape types.
+auto collide_bodies(body_storage const& bodies, std::span<convex_polygon const> polygons, std::span<body_pair const> pairs,
+                    std::span<std::uint32_t const> slots_a, std::span<std::uint32_t const> slots_b,
+                    std::span<contact> contacts) -> std::size_t;
+
+// Fraction of `displacement` at which a circle moving from `start` first touches a stationary one, or
+// anything above one if it doesn't. Circles that already overlap at the start are left to the discrete path.
+auto time_of_impact(real2 const& start, real2 const& displacement, real radius,
+                    real2 const& center, real other_radius) -> real;
+
+// Circle against a static box. The normal points from the circle into the box, as for circle pairs.
+auto collide_circle_box(real2 const& center, real radius, real2 const& min, real2 const& max, contact& result) -> bool;
+
+// As above, against a stationary box
+auto time_of_impact(real2 const& start, real2 const& displacement, real radius,
+                    real2 const& min, real2 const& max) -> real;
+
+}
+
+#endif // ENGINE_PHYSICS_NARROWPHASE_H
@@ -3,114 +3,987 @@
 
 #include "physics.h"
 
+#include <physics/integrator.h>
+#include <physics/narrowphase.h>
+#include <core/profiler.h>
+
+#include <chrono>
+#include <algorithm>
+
 namespace xc {
 
-class collision_manifold {
-public:
-    collision_manifold(physics_body_component const& body_a, physics_body_component const& body_b)
-        : _body_a{&body_a}, _body_b{&body_b} {
-        solve_circle_circle();
-    }
+auto static constexpr LINEAR_SLEEP_TOLERANCE = real{2};     // pixels per second
+auto static constexpr ANGULAR_SLEEP_TOLERANCE = real{2.f * DEG2RAD};
+auto static constexpr TIME_TO_SLEEP = real{0.5f};
 
-    std::vector<vector2> contact_points{};
-    float collision_penetration = 0.f;
-    vector2 collision_normal = vector2{0.f, 0.f};
+auto static constexpr DEFAULT_CATEGORY = std::uint32_t{1};
+auto static constexpr DEFAULT_MASK = ~std::uint32_t{0};
 
-private:
-    auto solve_circle_circle() -> void {
-        collision_normal = _body_b->position - _body_a->position;
-        auto collision_distance_sq = length_sq(collision_normal);
+auto static constexpr NARROWPHASE_CHUNK_SIZE = std::size_t{1024};
 
-        auto collision_radius = _body_a->radius + _body_b->radius;
-        if (collision_distance_sq >= collision_radius * collision_radius) return;
+auto static constexpr MAX_SWEEP_SUBSTEPS = 4;
 
-        auto distance = std::sqrt(collision_distance_sq);
+auto static constexpr SOLVER_ITERATIONS = 8;
+auto static constexpr TILE_KEY = entity_id{1} << 31;
+auto static constexpr DEFAULT_FRICTION = real{0.2f};
 
-        if (distance == 0.f) {
-            collision_penetration = _body_a->radius;
-            collision_normal = vector2{1.f, 0.f};
-            contact_points.emplace_back(_body_a->position);
-        } else {
-            collision_penetration = _body_a->radius;
-            collision_normal /= distance;
-            contact_points.emplace_back(collision_normal * _body_a->radius + _body_a->position);
-        }
-    }
+// Adds the time until the end of the scope to one of the stats
+class stage_timer {
+public:
+    explicit stage_timer(double& milliseconds) : _milliseconds{milliseconds}, _start{std::chrono::steady_clock::now()} {}
+    ~stage_timer() { _milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count(); }
 
-    physics_body_component const* _body_a, *_body_b;
+private:
+    double& _milliseconds;
+    std::chrono::steady_clock::time_point _start;
 };
 
-physics::physics(std::shared_ptr<xc::scene> scene) : _scene{std::move(scene)}, _gravity{0.f, 0.f} {}
+// The broadphase only has to be conservative, so it works in floats whatever the simulation scalar
+auto static body_bounds(real2 const& position, real const radius) -> aabb {
+    auto const center = to_vector2(position);
+    auto const extent = static_cast<float>(radius);
+    return {center - extent, center + extent};
+}
+
+auto static swept_bounds(real2 const& position, real2 const& displacement, real const radius) -> aabb {
+    auto bounds = body_bounds(position, radius);
+    auto const offset = to_vector2(displacement);
+    (offset.x < 0.f ? bounds.min.x : bounds.max.x) += offset.x;
+    (offset.y < 0.f ? bounds.min.y : bounds.max.y) += offset.y;
+    return bounds;
+}
+
+auto static ordered_pair(entity_id const a, entity_id const b) -> body_pair {
+    return {std::min(a, b), std::max(a, b)};
+}
+
+auto static pair_less(body_pair const& a, body_pair const& b) -> bool {
+    return a.a < b.a || (a.a == b.a && a.b < b.b);
+}
+
+physics::physics(std::shared_ptr<xc::scene> scene, broadphase_type const type, float const cell_size, std::uint32_t const worker_count)
+    : _gravity{real{0}, real{0}}, _scene{std::move(scene)},
+      _dynamic_broadphase{broadphase::create(type, cell_size)},
+      _static_broadphase{broadphase::create(broadphase_type::eTree, cell_size, false)},
+      _sensor_broadphase{broadphase::create(broadphase_type::eTree, cell_size, false)},
+      _tile_broadphase{broadphase::create(broadphase_type::eTree, cell_size, false)},
+      _workers{worker_count} {}
 
 physics::~physics() = default;
 
-auto physics::create(std::shared_ptr<xc::scene> scene) -> std::shared_ptr<physics> {
-    return std::shared_ptr<physics>{new physics{std::move(scene)}};
+auto physics::create(std::shared_ptr<xc::scene> scene, broadphase_type const type, float const cell_size,
+                     std::uint32_t const worker_count) -> std::shared_ptr<physics> {
+    return std::shared_ptr<physics>{new physics{std::move(scene), type, cell_size, worker_count}};
 }
 
 auto physics::create_body(vector2 const &position, float const radius, bool const is_dynamic) -> physics_body_component {
     auto body = physics_body_component{};
 
-    auto mass = 1.f / PI * radius * radius; // * density = 1.0
-    auto inertia_tensor = mass * radius * radius;
+    auto const body_radius = real{radius};
+    auto mass = real{1.f / PI} * body_radius * body_radius; // * density = 1.0
+    auto inertia_tensor = mass * body_radius * body_radius;
+
+    body.radius = body_radius;
+    body.position = body.previous_position = to_real2(position);
+    body.inverse_mass = is_dynamic ? real{1} / mass : real{0};
+    body.inverse_inertia_tensor = is_dynamic ? real{1} / inertia_tensor : real{0};
+    body.friction = DEFAULT_FRICTION;
+    body.category = DEFAULT_CATEGORY;
+    body.mask = DEFAULT_MASK;
+
+    return body;
+}
+
+// Mass per unit area that gives circles their r^2 / pi
+auto static constexpr DENSITY = 1.f / (PI * PI);
+
+auto static dynamic_body(vector2 const& position, float const mass, float const inertia, bool const is_dynamic) -> physics_body_component {
+    auto body = physics_body_component{};
+
+    body.position = body.previous_position = to_real2(position);
+    body.inverse_mass = is_dynamic ? real{1.f / mass} : real{0};
+    body.inverse_inertia_tensor = is_dynamic && inertia > 0.f ? real{1.f / inertia} : real{0};
+    body.friction = DEFAULT_FRICTION;
+    body.category = DEFAULT_CATEGORY;
+    body.mask = DEFAULT_MASK;
+
+    return body;
+}
+
+auto physics::create_box(vector2 const& position, vector2 const& half_extents, bool const is_dynamic) -> physics_body_component {
+    auto const mass = 4.f * half_extents.x * half_extents.y * DENSITY;
+
+    auto body = dynamic_body(position, mass, 0.f, is_dynamic);
+    body.shape = shape_type::eBox;
+    body.extents = to_real2(half_extents);
+    return body;
+}
+
+auto physics::create_capsule(vector2 const& position, float const half_length, float const radius, bool const is_dynamic) -> physics_body_component {
+    auto const mass = (4.f * half_length * radius + PI * radius * radius) * DENSITY;
 
-    body.radius = radius;
-    body.position = position;
-    body.inverse_mass = is_dynamic ? 1.f / mass : 0.f;
-    body.inverse_inertia_tensor = 1.f / inertia_tensor;
+    // Inertia of the bounding box, close enough for a capsule
+    auto const length = 2.f * (half_length + radius);
+    auto const inertia = mass * (length * length + 4.f * radius * radius) / 12.f;
 
+    auto body = dynamic_body(position, mass, inertia, is_dynamic);
+    body.shape = shape_type::eCapsule;
+    body.radius = real{radius};
+    body.extents = real2{real{half_length}, real{0}};
+    return body;
+}
+
+auto physics::create_polygon(vector2 const& position, std::span<vector2 const> vertices, bool const is_dynamic) -> physics_body_component {
+    if (vertices.size() < 3 || vertices.size() > MAX_POLYGON_VERTICES) throw std::runtime_error("Polygons take 3 to 8 vertices");
+
+    // Area and inertia about the position, from the triangles fanning out of it
+    auto area = 0.f, inertia = 0.f;
+    for (auto i = std::size_t{0}; i < vertices.size(); ++i) {
+        auto const& a = vertices[i];
+        auto const& b = vertices[(i + 1) % vertices.size()];
+        auto const triangle = cross(a, b) * 0.5f;
+
+        area += triangle;
+        inertia += triangle * (dot(a, a) + dot(a, b) + dot(b, b)) / 6.f;
+    }
+
+    auto body = dynamic_body(position, std::abs(area) * DENSITY, std::abs(inertia) * DENSITY, is_dynamic);
+    body.shape = shape_type::ePolygon;
+    body.polygon = static_cast<std::uint32_t>(_polygons.size());
+    _polygons.push_back(make_polygon(vertices));
     return body;
 }
 
 auto physics::add_force(entity_id entity, vector2 const &force) -> void {
-    _scene->get_component<physics_body_component>(entity).force += force;
+    _scene->get_component<physics_body_component>(entity).force += to_real2(force);
+    wake(entity);
+}
+
+auto physics::add_tile_layer(std::span<std::int64_t const> cells, std::uint32_t const columns, std::uint32_t const rows,
+                             float const tile_size, vector2 const& origin, std::uint32_t const category) -> void {
+    _merged_tiles.clear();
+    merge_tiles(cells, columns, rows, tile_size, origin, _merged_tiles);
+
+    for (auto const& bounds : _merged_tiles)
+        _tiles.push_back({bounds, category, _tile_broadphase->create_proxy(bounds, _tiles.size())});
+
+    if (!_merged_tiles.empty()) _tile_categories |= category;
+}
+
+auto physics::clear_tiles() -> void {
+    for (auto const& tile : _tiles) _tile_broadphase->destroy_proxy(tile.proxy);
+
+    _tiles.clear();
+    _tile_categories = 0;
+}
+
+auto physics::save(std::vector<std::byte>& buffer) const -> void {
+    buffer.clear();
+    auto writer = snapshot_writer{buffer};
+
+    writer.write(_gravity);
+    writer.write(_static_categories);
+    writer.write(_sensor_categories);
+    writer.write(_tile_categories);
+
+    _storage.save(writer);
+    writer.write(_polygons);
+    writer.write(_bodies);
+    writer.write(_body_entities);
+
+    for (auto entity : _body_entities)
+        writer.write(_scene->get_component<physics_body_component>(entity));
+
+    for (auto* tree : {_dynamic_broadphase.get(), _static_broadphase.get(), _sensor_broadphase.get(), _tile_broadphase.get()})
+        tree->save(writer);
+    writer.write(_tiles);
+
+    _solver.save(writer);
+    writer.write(_touching);
+    writer.write(_swept_pairs);
+    writer.write(_contact_events);
+
+    writer.write(_sleeping_islands.size());
+    for (auto const& island : _sleeping_islands) writer.write(island);
+    writer.write(_free_islands);
+}
+
+auto physics::restore(std::span<std::byte const> buffer) -> void {
+    auto reader = snapshot_reader{buffer};
+
+    reader.read(_gravity);
+    reader.read(_static_categories);
+    reader.read(_sensor_categories);
+    reader.read(_tile_categories);
+
+    _storage.restore(reader);
+    reader.read(_polygons);
+    reader.read(_bodies);
+    reader.read(_body_entities);
+
+    auto body = physics_body_component{};
+    for (auto entity : _body_entities) {
+        reader.read(body);
+        if (_scene->has_component<physics_body_component>(entity)) _scene->get_component<physics_body_component>(entity) = body;
+    }
+
+    for (auto* tree : {_dynamic_broadphase.get(), _static_broadphase.get(), _sensor_broadphase.get(), _tile_broadphase.get()})
+        tree->restore(reader);
+    reader.read(_tiles);
+
+    _solver.restore(reader);
+    reader.read(_touching);
+    reader.read(_swept_pairs);
+    reader.read(_contact_events);
+
+    auto island_count = std::size_t{0};
+    reader.read(island_count);
+    _sleeping_islands.resize(island_count);
+    for (auto& island : _sleeping_islands) reader.read(island);
+    reader.read(_free_islands);
+}
+
+auto physics::interpolated_pose(entity_id const entity, float const alpha) const -> pose {
+    auto const& body = _scene->get_component<physics_body_component>(entity);
+    auto const previous = to_vector2(body.previous_position);
+    auto const previous_rotation = static_cast<float>(body.previous_rotation);
+
+    return {lerp(previous, to_vector2(body.position), alpha),
+            previous_rotation + (static_cast<float>(body.rotation) - previous_rotation) * alpha};
+}
+
+auto physics::raycast(vector2 const& from, vector2 const& to, raycast_hit& hit, std::uint32_t const mask) -> bool {
+    query_bodies(mask, [&](broadphase& tree, std::vector<entity_id>& results) { tree.query(from, to, results); });
+
+    auto const start = to_real2(from);
+    auto const delta = to_real2(to) - start;
+    auto closest = real{2};
+
+    auto const record = [&](entity_id const entity, real const fraction, real2 const& normal) {
+        closest = fraction;
+        hit.entity = entity;
+        hit.fraction = static_cast<float>(fraction);
+        hit.point = to_vector2(start + delta * fraction);
+        hit.normal = to_vector2(normal);
+    };
+
+    for (auto entity : _query_results) {
+        auto const slot = _bodies[entity].slot;
+        auto const is_circle = _storage.shape[slot] == shape_type::eCircle;
+
+        auto normal = real2{};
+        auto const fraction = is_circle
+            ? time_of_impact(start, delta, real{0}, _storage.position(slot), _storage.radius[slot])
+            : raycast_shape(shape_at(slot), start, delta, normal);
+        if (fraction > real{1} || fraction >= closest) continue;
+
+        if (is_circle) normal = normalize(start + delta * fraction - _storage.position(slot));
+        record(entity, fraction, normal);
+    }
+
+    // A body level with a wall is the one reported
+    for (auto tile : _tile_results) {
+        auto const& bounds = _tiles[tile].bounds;
+        auto normal = real2{};
+        auto const fraction = raycast_shape(box_shape(to_real2(bounds.min), to_real2(bounds.max)), start, delta, normal);
+        if (fraction > real{1} || fraction >= closest) continue;
+
+        record(TILE_ENTITY, fraction, normal);
+    }
+
+    return closest <= real{1};
+}
+
+auto physics::overlap_circle(vector2 const& center, float const radius, std::vector<entity_id>& entities, std::uint32_t const mask) -> void {
+    auto const circle_center = to_real2(center);
+    auto const circle_radius = real{radius};
+    query_bodies(mask, [&](broadphase& tree, std::vector<entity_id>& results) { tree.query(body_bounds(circle_center, circle_radius), results); });
+
+    auto result = contact{};
+    for (auto entity : _query_results) {
+        auto const slot = _bodies[entity].slot;
+        if (_storage.shape[slot] != shape_type::eCircle) {
+            if (collide_shapes(circle_shape(circle_center, circle_radius), shape_at(slot), result)) entities.push_back(entity);
+            continue;
+        }
+
+        auto const distance = circle_radius + _storage.radius[slot];
+        if (length_sq(_storage.position(slot) - circle_center) < distance * distance) entities.push_back(entity);
+    }
+
+    for (auto tile : _tile_results) {
+        auto const& bounds = _tiles[tile].bounds;
+        if (!collide_shapes(circle_shape(circle_center, circle_radius), box_shape(to_real2(bounds.min), to_real2(bounds.max)), result)) continue;
+
+        entities.push_back(TILE_ENTITY);
+        break;
+    }
 }
 
-auto physics::tick(float const step) -> void {
+auto physics::overlap_aabb(aabb const& bounds, std::vector<entity_id>& entities, std::uint32_t const mask) -> void {
+    query_bodies(mask, [&](broadphase& tree, std::vector<entity_id>& results) { tree.query(bounds, results); });
+
+    auto const min = to_real2(bounds.min);
+    auto const max = to_real2(bounds.max);
+
+    auto result = contact{};
+    for (auto entity : _query_results) {
+        auto const slot = _bodies[entity].slot;
+        if (_storage.shape[slot] != shape_type::eCircle) {
+            if (collide_shapes(box_shape(min, max), shape_at(slot), result)) entities.push_back(entity);
+            continue;
+        }
+
+        auto const position = _storage.position(slot);
+        auto const closest = real2{std::clamp(position.x, min.x, max.x), std::clamp(position.y, min.y, max.y)};
+        if (length_sq(position - closest) < _storage.radius[slot] * _storage.radius[slot]) entities.push_back(entity);
+    }
+
+    for (auto tile : _tile_results) {
+        auto const& tile_bounds = _tiles[tile].bounds;
+        if (!collide_shapes(box_shape(min, max), box_shape(to_real2(tile_bounds.min), to_real2(tile_bounds.max)), result)) continue;
+
+        entities.push_back(TILE_ENTITY);
+        break;
+    }
+}
+
+auto physics::nearest(vector2 const& point, float const max_distance, entity_id& entity, std::uint32_t const mask) -> bool {
+    auto const origin = to_real2(point);
+    query_bodies(mask, [&](broadphase& tree, std::vector<entity_id>& results) { tree.query(body_bounds(origin, real{max_distance}), results); });
+
+    // Measured to the body's surface, so a point inside a body is at distance zero
+    auto best = real{max_distance};
+    auto found = false;
+
+    for (auto candidate : _query_results) {
+        auto const slot = _bodies[candidate].slot;
+        auto const distance = _storage.shape[slot] == shape_type::eCircle
+            ? std::max(real{0}, length(_storage.position(slot) - origin) - _storage.radius[slot])
+            : shape_distance(shape_at(slot), origin);
+        if (distance > best || (found && distance == best && candidate > entity)) continue;
+
+        best = distance;
+        entity = candidate;
+        found = true;
+    }
+
+    // Walls lose ties to bodies, as TILE_ENTITY is above every entity id
+    for (auto tile : _tile_results) {
+        auto const& bounds = _tiles[tile].bounds;
+        auto const distance = shape_distance(box_shape(to_real2(bounds.min), to_real2(bounds.max)), origin);
+        if (distance > best || (found && distance == best)) continue;
+
+        best = distance;
+        entity = TILE_ENTITY;
+        found = true;
+    }
+
+    return found;
+}
+
+auto physics::tick(float const seconds) -> void {
+    profile_zone("physics::tick");
+
+    auto const step = real{seconds};
+    _stats = physics_stats{};
+
     auto body_entities = _scene->view<physics_body_component>().entities;
+    if (body_entities.empty() && _body_entities.empty()) return;
+
+    {
+        profile_zone("physics: sync bodies");
+        auto const timer = stage_timer{_stats.sync_ms};
+        sync_bodies(std::move(body_entities), _scene->get_components<physics_body_component>());
+    }
 
-    // Integrate forces
-    for (auto entity: body_entities) {
-        auto &body = _scene->get_component<physics_body_component>(entity);
+    {
+        profile_zone("physics: integrate forces");
+        auto const timer = stage_timer{_stats.integrate_forces_ms};
+        integrate_forces(_storage, _storage.awake_count, _gravity, step);
+    }
+
+    {
+        profile_zone("physics: broadphase");
+        auto const timer = stage_timer{_stats.broadphase_ms};
+        find_pairs();
+    }
 
-        // Skip if the body is static
-        if (body.inverse_mass == 0.f) continue;
+    {
+        profile_zone("physics: narrowphase");
+        auto const timer = stage_timer{_stats.narrowphase_ms};
+        collide_pairs();
+        collide_tiles();
+        update_contact_events();
 
-        body.velocity += (_gravity + body.inverse_mass * body.force) * step;
-        body.angular_velocity += body.inverse_inertia_tensor * body.torque * step;
+        // Sensors only report events; nothing pushes them or is pushed by them
+        std::erase_if(_contacts, [this](auto const& contact) {
+            return _bodies[contact.pair.a].is_sensor || _bodies[contact.pair.b].is_sensor;
+        });
     }
 
-    // Find collisions
-    for (auto i = std::size_t{0}; i < body_entities.size(); ++i) {
-        auto entity_a = body_entities[i];
-        auto& body_a = _scene->get_component<physics_body_component>(entity_a);
+    {
+        profile_zone("physics: solver");
+        auto const timer = stage_timer{_stats.solver_ms};
 
-        for (auto j = std::size_t{1}; j < body_entities.size(); ++j) {
-            auto entity_b = body_entities[j];
-            auto& body_b = _scene->get_component<physics_body_component>(entity_b);
+        // Anything touched by an awake body wakes up along with the rest of its island
+        for (auto const& contact : _contacts) {
+            wake(contact.pair.a);
+            wake(contact.pair.b);
+        }
+
+        // Both contact lists are sorted by pair, so merging them keeps the solver's keys ascending
+        auto tile_contact = _tile_contacts.cbegin();
+        auto const add_tile_contacts = [&](auto const& until) {
+            for (; tile_contact != until; ++tile_contact)
+                _solver.add_contact(*tile_contact, _bodies[tile_contact->pair.a].slot, contact_solver::WORLD_SLOT, _storage);
+        };
+
+        for (auto const& contact : _contacts) {
+            add_tile_contacts(std::partition_point(tile_contact, _tile_contacts.cend(), [&](auto const& tile) {
+                return pair_less(tile.pair, contact.pair);
+            }));
+            _solver.add_contact(contact, _bodies[contact.pair.a].slot, _bodies[contact.pair.b].slot, _storage);
+        }
+        add_tile_contacts(_tile_contacts.cend());
+
+        _solver.solve(_storage, step, SOLVER_ITERATIONS, _workers);
+    }
+
+    {
+        profile_zone("physics: integrate velocities");
+        auto const timer = stage_timer{_stats.integrate_velocities_ms};
+        find_fast_bodies(step);
+        integrate_velocities(_storage, _storage.awake_count, step);
+        sweep_fast_bodies(step);
+    }
+
+    {
+        // Proxies follow the bodies at the end of the step, so queries between ticks see where bodies are
+        profile_zone("physics: broadphase");
+        auto const timer = stage_timer{_stats.broadphase_ms};
+        for (auto slot = std::uint32_t{0}; slot < _storage.awake_count; ++slot) {
+            auto const bounds = bounds_of(slot);
+            _dynamic_broadphase->move_proxy(_bodies[_storage.entity[slot]].proxy, bounds, to_vector2(_storage.velocity(slot) * step));
+        }
+    }
+
+    {
+        profile_zone("physics: sleep");
+        auto const timer = stage_timer{_stats.sleep_ms};
+
+        auto& components = _scene->get_components<physics_body_component>();
+        for (auto slot = std::uint32_t{0}; slot < _storage.awake_count; ++slot)
+            _storage.store(slot, components[_storage.entity[slot]]);
+
+        update_sleep(step, components);
+    }
+
+    _stats.candidate_pairs = static_cast<std::uint32_t>(_pairs.size() + _tile_pairs.size());
+    _stats.contacts = static_cast<std::uint32_t>(_contacts.size() + _tile_contacts.size());
+    _stats.awake_bodies = _storage.awake_count;
+    _stats.sleeping_bodies = _storage.dynamic_count - _storage.awake_count;
+}
 
-            auto new_manifold = collision_manifold(body_a, body_b);
-            if (!new_manifold.contact_points.empty()) {
-                _scene->add_component<collision_component>(entity_a, entity_b);
-                _scene->add_component<collision_component>(entity_b, entity_a);
+auto physics::sync_bodies(std::vector<entity_id> body_entities, std::vector<physics_body_component>& components) -> void {
+    // Both entity lists are sorted, so bodies that disappeared since the last step fall out of a merge
+    auto current = body_entities.begin();
+    for (auto entity : _body_entities) {
+        while (current != body_entities.end() && *current < entity) ++current;
+        if (current != body_entities.end() && *current == entity) continue;
+
+        remove_body(entity);
+    }
+
+    if (!body_entities.empty() && body_entities.back() >= _bodies.size())
+        _bodies.resize(body_entities.back() + 1);
+
+    for (auto entity : body_entities)
+        if (_bodies[entity].proxy == null_proxy) add_body(entity, components[entity]);
+
+    // Gameplay may have pushed or moved awake bodies since the last step
+    for (auto slot = std::uint32_t{0}; slot < _storage.awake_count; ++slot) {
+        auto const entity = _storage.entity[slot];
+        auto const& body = components[entity];
+        auto const moved = body.position.x != _storage.position_x[slot] || body.position.y != _storage.position_y[slot];
+
+        _storage.load(slot, body);
+        if (moved) _dynamic_broadphase->move_proxy(_bodies[entity].proxy, bounds_of(slot), vector2{0.f, 0.f});
+        _bodies[entity].category = body.category;
+        _bodies[entity].mask = body.mask;
+        _bodies[entity].is_bullet = body.is_bullet;
+    }
+
+    _body_entities = std::move(body_entities);
+}
+
+auto physics::add_body(entity_id const entity, physics_body_component const& body) -> void {
+    auto& state = _bodies[entity];
+    state.is_sensor = body.is_sensor;
+    state.is_bullet = body.is_bullet;
+    state.is_static = body.is_sensor || body.inverse_mass == real{0};
+    state.category = body.category;
+    state.mask = body.mask;
+    if (state.is_static) (state.is_sensor ? _sensor_categories : _static_categories) |= body.category;
+
+    auto slot = _storage.push_back(entity);
+    state.slot = slot;
+
+    // New dynamic bodies start awake
+    if (!state.is_static) {
+        swap_slots(slot, _storage.dynamic_count);
+        slot = _storage.dynamic_count++;
+        swap_slots(slot, _storage.awake_count);
+        slot = _storage.awake_count++;
+    }
+
+    _storage.load(slot, body);
+    state.proxy = broadphase_of(state).create_proxy(bounds_of(slot), entity);
+}
+
+auto physics::remove_body(entity_id const entity) -> void {
+    auto& state = _bodies[entity];
+    broadphase_of(state).destroy_proxy(state.proxy);
+
+    // Walk the slot out through each partition to the end of the storage
+    auto slot = state.slot;
+    if (slot < _storage.awake_count) {
+        swap_slots(slot, --_storage.awake_count);
+        slot = _storage.awake_count;
+    }
+    if (slot < _storage.dynamic_count) {
+        swap_slots(slot, --_storage.dynamic_count);
+        slot = _storage.dynamic_count;
+    }
+    swap_slots(slot, _storage.size() - 1);
+    _storage.pop_back();
+
+    state = body_state{};
+}
+
+auto physics::swap_slots(std::uint32_t const a, std::uint32_t const b) -> void {
+    if (a == b) return;
+
+    _storage.swap(a, b);
+    _bodies[_storage.entity[a]].slot = a;
+    _bodies[_storage.entity[b]].slot = b;
+}
+
+auto physics::broadphase_of(body_state const& state) const -> broadphase& {
+    if (state.is_sensor) return *_sensor_broadphase;
+    return state.is_static ? *_static_broadphase : *_dynamic_broadphase;
+}
+
+auto physics::bounds_of(std::uint32_t const slot) const -> aabb {
+    if (_storage.shape[slot] == shape_type::eCircle) return body_bounds(_storage.position(slot), _storage.radius[slot]);
+    return shape_bounds(shape_at(slot));
+}
+
+auto physics::shape_at(std::uint32_t const slot) const -> world_shape {
+    return shape_of(_storage, _polygons, slot);
+}
+
+template<class F> auto physics::query_bodies(std::uint32_t const mask, F&& query) -> void {
+    _query_results.clear();
+    _tile_results.clear();
+
+    query(*_dynamic_broadphase, _query_results);
+    if (mask & _static_categories) query(*_static_broadphase, _query_results);
+    if (mask & _sensor_categories) query(*_sensor_broadphase, _query_results);
+    if (mask & _tile_categories) query(*_tile_broadphase, _tile_results);
+
+    std::erase_if(_query_results, [&](entity_id const entity) { return !(_bodies[entity].category & mask); });
+    std::erase_if(_tile_results, [&](entity_id const tile) { return !(_tiles[tile].category & mask); });
+}
+
+auto physics::should_collide(entity_id const a, entity_id const b) const -> bool {
+    auto const& state_a = _bodies[a];
+    auto const& state_b = _bodies[b];
+    return (state_a.category & state_b.mask) && (state_b.category & state_a.mask);
+}
+
+auto physics::find_pairs() -> void {
+    _pairs.clear();
+    _tile_pairs.clear();
+
+    // Dynamic against dynamic, skipping pairs that are both asleep or filtered out
+    _dynamic_broadphase->update_pairs(_pairs);
+    std::erase_if(_pairs, [this](auto const& pair) {
+        return (_bodies[pair.a].is_sleeping && _bodies[pair.b].is_sleeping) || !should_collide(pair.a, pair.b);
+    });
+
+    // Awake dynamic against static and sensors, not even querying a tree whose categories are all masked out
+    for (auto slot = std::uint32_t{0}; slot < _storage.awake_count; ++slot) {
+        auto const entity = _storage.entity[slot];
+        auto const bounds = bounds_of(slot);
+
+        _query_results.clear();
+        if (_bodies[entity].mask & _static_categories) _static_broadphase->query(bounds, _query_results);
+        if (_bodies[entity].mask & _sensor_categories) _sensor_broadphase->query(bounds, _query_results);
+
+        for (auto other : _query_results)
+            if (should_collide(entity, other)) _pairs.push_back(ordered_pair(entity, other));
+
+        if (!(_bodies[entity].mask & _tile_categories)) continue;
+
+        _tile_results.clear();
+        _tile_broadphase->query(bounds, _tile_results);
+        for (auto tile : _tile_results)
+            if (_bodies[entity].mask & _tiles[tile].category) _tile_pairs.push_back({entity, tile});
+    }
+
+    std::sort(_pairs.begin(), _pairs.end(), pair_less);
+    std::sort(_tile_pairs.begin(), _tile_pairs.end(), pair_less);
+}
+
+auto physics::collide_pairs() -> void {
+    // Pairs are cut into fixed-size chunks rather than one range per thread, and each chunk writes its
+    // contacts to the front of its own slice of the buffer. Compacting the slices in chunk order then
+    // gives the same contact list whatever the thread count.
+    auto const pair_count = _pairs.size();
+    auto const chunk_count = (pair_count + NARROWPHASE_CHUNK_SIZE - 1) / NARROWPHASE_CHUNK_SIZE;
+
+    _pair_slots_a.resize(pair_count);
+    _pair_slots_b.resize(pair_count);
+    _contacts.resize(pair_count);
+    _chunk_contact_counts.resize(chunk_count);
+
+    _workers.run(chunk_count, [this, pair_count](std::size_t const chunk) {
+        auto const begin = chunk * NARROWPHASE_CHUNK_SIZE;
+        auto const count = std::min(NARROWPHASE_CHUNK_SIZE, pair_count - begin);
+
+        for (auto i = begin; i < begin + count; ++i) {
+            _pair_slots_a[i] = _bodies[_pairs[i].a].slot;
+            _pair_slots_b[i] = _bodies[_pairs[i].b].slot;
+        }
+
+        _chunk_contact_counts[chunk] = collide_bodies(_storage, _polygons,
+            std::span{_pairs}.subspan(begin, count),
+            std::span{_pair_slots_a}.subspan(begin, count), std::span{_pair_slots_b}.subspan(begin, count),
+            std::span{_contacts}.subspan(begin, count));
+    });
+
+    auto contact_count = std::size_t{0};
+    for (auto chunk = std::size_t{0}; chunk < chunk_count; ++chunk) {
+        auto const begin = _contacts.begin() + static_cast<std::ptrdiff_t>(chunk * NARROWPHASE_CHUNK_SIZE);
+        std::copy_n(begin, _chunk_contact_counts[chunk], _contacts.begin() + static_cast<std::ptrdiff_t>(contact_count));
+        contact_count += _chunk_contact_counts[chunk];
+    }
+    _contacts.resize(contact_count);
+}
+
+auto physics::collide_tiles() -> void {
+    // Tile pairs are a handful per body touching level geometry, not worth spreading over the workers
+    _tile_contacts.clear();
+
+    auto result = contact{};
+    for (auto const& pair : _tile_pairs) {
+        auto const slot = _bodies[pair.a].slot;
+        auto const& bounds = _tiles[pair.b].bounds;
+
+        auto const hit = _storage.shape[slot] == shape_type::eCircle
+            ? collide_circle_box(_storage.position(slot), _storage.radius[slot], to_real2(bounds.min), to_real2(bounds.max), result)
+            : collide_shapes(shape_at(slot), box_shape(to_real2(bounds.min), to_real2(bounds.max)), result);
+        if (!hit) continue;
+
+        result.pair = {pair.a, TILE_KEY | pair.b};
+        _tile_contacts.push_back(result);
+    }
+}
+
+auto physics::update_contact_events() -> void {
+    _contact_events.clear();
+    _next_touching.clear();
+
+    // Pairs between bodies that are both asleep or static aren't tested, but they're still touching
+    auto const is_resting = [this](entity_id const entity) {
+        auto const& state = _bodies[entity];
+        return state.proxy != null_proxy && (state.is_static || state.is_sleeping);
+    };
+
+    auto const separate = [&](body_pair const& pair) {
+        if (is_resting(pair.a) && is_resting(pair.b)) {
+            _contact_events.push_back({pair, contact_phase::eStay});
+            _next_touching.push_back(pair);
+        } else {
+            _contact_events.push_back({pair, contact_phase::eEnd});
+        }
+    };
+
+    _event_pairs.clear();
+    for (auto const& contact : _contacts) _event_pairs.push_back(contact.pair);
+
+    // Sensors crossed inside a single step last tick are reported as touching for this one
+    if (!_swept_pairs.empty()) {
+        std::erase_if(_swept_pairs, [this](auto const& pair) {
+            return _bodies[pair.a].proxy == null_proxy || _bodies[pair.b].proxy == null_proxy;
+        });
+        _event_pairs.insert(_event_pairs.end(), _swept_pairs.begin(), _swept_pairs.end());
+        _swept_pairs.clear();
+
+        std::sort(_event_pairs.begin(), _event_pairs.end(), pair_less);
+        _event_pairs.erase(std::unique(_event_pairs.begin(), _event_pairs.end(), [](auto const& a, auto const& b) {
+            return a.a == b.a && a.b == b.b;
+        }), _event_pairs.end());
+    }
+
+    // Both lists are sorted by pair, so one merge finds what began, stayed and ended
+    auto previous = _touching.begin();
+    for (auto const& pair : _event_pairs) {
+        while (previous != _touching.end() && pair_less(*previous, pair)) separate(*previous++);
+
+        auto const began = previous == _touching.end() || pair_less(pair, *previous);
+        if (!began) ++previous;
+
+        _contact_events.push_back({pair, began ? contact_phase::eBegin : contact_phase::eStay});
+        _next_touching.push_back(pair);
+    }
+    while (previous != _touching.end()) separate(*previous++);
+
+    std::swap(_touching, _next_touching);
+}
+
+auto physics::find_fast_bodies(real const step) -> void {
+    _fast_bodies.clear();
+
+    for (auto slot = std::uint32_t{0}; slot < _storage.awake_count; ++slot) {
+        auto const velocity = _storage.velocity(slot);
+        auto const radius = inner_radius(_storage, _polygons, slot);
+
+        if (_bodies[_storage.entity[slot]].is_bullet || length_sq(velocity) * step * step > radius * radius)
+            _fast_bodies.push_back({slot, _storage.position(slot), velocity});
+    }
+}
+
+auto physics::sweep_fast_bodies(real const step) -> void {
+    // Fast bodies were moved by the integrator like everything else; redo their motion as a sweep from the
+    // start of the step, stopping at the first thing hit and carrying on along the response velocity. Shapes
+    // other than circles sweep as the largest circle inside them.
+    for (auto const& fast : _fast_bodies) {
+        auto const slot = fast.slot;
+        auto const entity = _storage.entity[slot];
+        auto const& state = _bodies[entity];
+        auto const radius = inner_radius(_storage, _polygons, slot);
+
+        auto position = fast.start;
+        auto velocity = fast.velocity;
+        auto remaining = step;
+
+        for (auto substep = 0; substep < MAX_SWEEP_SUBSTEPS && remaining > real{0}; ++substep) {
+            auto const displacement = velocity * remaining;
+
+            // Only bullets sweep against other dynamic bodies; everything else relies on the discrete path there
+            _query_results.clear();
+            auto const bounds = swept_bounds(position, displacement, radius);
+            if (state.mask & _static_categories) _static_broadphase->query(bounds, _query_results);
+            if (state.mask & _sensor_categories) _sensor_broadphase->query(bounds, _query_results);
+            if (state.is_bullet) _dynamic_broadphase->query(bounds, _query_results);
+
+            auto hit_time = real{2};
+            auto hit_entity = entity;
+            auto hit_tile = _tiles.size();
+            auto hit_normal = real2{};
+            _swept_sensors.clear();
+
+            for (auto other : _query_results) {
+                if (other == entity || !should_collide(entity, other)) continue;
+
+                auto const other_slot = _bodies[other].slot;
+                auto normal = real2{};
+                auto time = real{2};
+
+                // A miss has no point of contact to take a normal from
+                switch (_storage.shape[other_slot]) {
+                    case shape_type::eCircle:
+                        time = time_of_impact(position, displacement, radius, _storage.position(other_slot), _storage.radius[other_slot]);
+                        if (time <= real{1}) normal = normalize(position + displacement * time - _storage.position(other_slot));
+                        break;
+                    case shape_type::eBox: {
+                        auto const shape = shape_at(other_slot);
+                        auto const &min = shape.vertices[0], &max = shape.vertices[2];
+                        time = time_of_impact(position, displacement, radius, min, max);
+                        if (time > real{1}) break;
+
+                        auto const point = position + displacement * time;
+                        normal = normalize(point - real2{std::clamp(point.x, min.x, max.x), std::clamp(point.y, min.y, max.y)});
+                        break;
+                    }
+                    default: {
+                        auto shape = shape_at(other_slot);
+                        shape.radius += radius;
+                        time = raycast_shape(shape, position, displacement, normal);
+                        break;
+                    }
+                }
+                if (time > real{1}) continue;
+
+                if (_bodies[other].is_sensor) {
+                    _swept_sensors.push_back({other, time});
+                } else if (time < hit_time) {
+                    hit_time = time;
+                    hit_entity = other;
+                    hit_normal = normal;
+                }
+            }
+
+            _tile_results.clear();
+            if (state.mask & _tile_categories) _tile_broadphase->query(bounds, _tile_results);
+
+            for (auto tile : _tile_results) {
+                auto const& box = _tiles[tile];
+                if (!(state.mask & box.category)) continue;
+
+                auto const time = time_of_impact(position, displacement, radius, to_real2(box.bounds.min), to_real2(box.bounds.max));
+                if (time < hit_time) {
+                    hit_time = time;
+                    hit_tile = tile;
+                }
+            }
+
+            // Sensors beyond the point of impact were never reached
+            for (auto const& sensor : _swept_sensors)
+                if (sensor.time <= hit_time) _swept_pairs.push_back(ordered_pair(entity, sensor.entity));
+
+            // hit_tile is only set when a tile is reached before any body
+            auto const hit_world = hit_tile != _tiles.size();
+            if (hit_entity == entity && !hit_world) {
+                position += displacement;
+                break;
+            }
+
+            position += displacement * hit_time;
+            remaining *= real{1} - hit_time;
+
+            // Bounce off what was hit as a single frictionless contact; tiles, sleeping and static bodies don't give
+            auto const& other = _bodies[hit_entity];
+            auto const other_slot = other.slot;
+            auto const other_moves = !hit_world && !other.is_static && !other.is_sleeping;
+
+            auto normal = hit_normal;
+            if (hit_world) {
+                auto const& box = _tiles[hit_tile].bounds;
+                auto const min = to_real2(box.min), max = to_real2(box.max);
+                normal = normalize(position - real2{std::clamp(position.x, min.x, max.x), std::clamp(position.y, min.y, max.y)});
+            }
+
+            auto const other_velocity = other_moves ? _storage.velocity(other_slot) : real2{real{0}, real{0}};
+            auto const normal_velocity = dot(velocity - other_velocity, normal);
+            if (normal_velocity >= real{0}) continue;
+
+            auto const inverse_mass = _storage.inverse_mass[slot];
+            auto const other_inverse_mass = other_moves ? _storage.inverse_mass[other_slot] : real{0};
+            auto const restitution = hit_world ? _storage.restitution[slot] : std::max(_storage.restitution[slot], _storage.restitution[other_slot]);
+            auto const impulse = normal * (-(real{1} + restitution) * normal_velocity / (inverse_mass + other_inverse_mass));
+
+            velocity += impulse * inverse_mass;
+            _storage.velocity_x[slot] += impulse.x * inverse_mass;
+            _storage.velocity_y[slot] += impulse.y * inverse_mass;
+
+            if (other_moves) {
+                _storage.velocity_x[other_slot] -= impulse.x * other_inverse_mass;
+                _storage.velocity_y[other_slot] -= impulse.y * other_inverse_mass;
             }
         }
+
+        _storage.position_x[slot] = position.x;
+        _storage.position_y[slot] = position.y;
     }
+}
 
-    // Integrate velocities
-    for (auto entity: body_entities) {
-        auto &body = _scene->get_component<physics_body_component>(entity);
+auto physics::update_sleep(real const step, std::vector<physics_body_component>& components) -> void {
+    auto const awake_count = _storage.awake_count;
 
-        body.position += body.velocity * step;
-        body.rotation += body.angular_velocity * step;
+    auto const find = [this](std::uint32_t slot) {
+        while (_island_parents[slot] != slot) {
+            _island_parents[slot] = _island_parents[_island_parents[slot]];
+            slot = _island_parents[slot];
+        }
+        return slot;
+    };
+
+    _island_parents.resize(awake_count);
+    for (auto slot = std::uint32_t{0}; slot < awake_count; ++slot) {
+        auto& state = _bodies[_storage.entity[slot]];
+
+        auto const resting = length_sq(_storage.velocity(slot)) < LINEAR_SLEEP_TOLERANCE * LINEAR_SLEEP_TOLERANCE
+                          && abs(_storage.angular_velocity[slot]) < ANGULAR_SLEEP_TOLERANCE;
+
+        state.sleep_time = resting ? state.sleep_time + step : real{0};
+        _island_parents[slot] = slot;
+    }
+
+    // Islands are the connected components of the contact graph between dynamic bodies
+    for (auto const& contact : _contacts) {
+        auto const& state_a = _bodies[contact.pair.a];
+        auto const& state_b = _bodies[contact.pair.b];
+        if (state_a.is_static || state_b.is_static) continue;
 
-        body.force = {0.f, 0.f};
-        body.torque = 0.f;
+        auto const root_a = find(state_a.slot);
+        auto const root_b = find(state_b.slot);
+        if (root_a != root_b) _island_parents[std::max(root_a, root_b)] = std::min(root_a, root_b);
+    }
 
-        // Apply damping
-        body.velocity *= 1.f / (1.f + body.damping * step);
-        body.angular_velocity *= 1.f / (1.f + body.damping * step);
+    // An island sleeps once every body in it has been resting long enough
+    _island_sleep_time.assign(awake_count, TIME_TO_SLEEP);
+    for (auto slot = std::uint32_t{0}; slot < awake_count; ++slot) {
+        auto const root = find(slot);
+        _island_sleep_time[root] = std::min(_island_sleep_time[root], _bodies[_storage.entity[slot]].sleep_time);
     }
+
+    _island_slots.assign(awake_count, ~std::uint32_t{0});
+    for (auto slot = std::uint32_t{0}; slot < awake_count; ++slot) {
+        auto const root = find(slot);
+        if (_island_sleep_time[root] < TIME_TO_SLEEP) continue;
+
+        auto& island = _island_slots[root];
+        if (island == ~std::uint32_t{0}) {
+            if (_free_islands.empty()) {
+                island = static_cast<std::uint32_t>(_sleeping_islands.size());
+                _sleeping_islands.emplace_back();
+            } else {
+                island = _free_islands.back();
+                _free_islands.pop_back();
+            }
+        }
+
+        auto const entity = _storage.entity[slot];
+        _sleeping_islands[island].push_back(entity);
+
+        auto& state = _bodies[entity];
+        state.is_sleeping = true;
+        state.island = island;
+
+        // Settle the pose too, so a sleeping body isn't drawn between its last two positions
+        _storage.velocity_x[slot] = _storage.velocity_y[slot] = _storage.angular_velocity[slot] = real{0};
+        _storage.store(slot, components[entity]);
+        components[entity].previous_position = components[entity].position;
+        components[entity].previous_rotation = components[entity].rotation;
+    }
+
+    // Move the new sleepers out of the awake prefix, back to front so every swapped-in slot is already settled
+    for (auto slot = awake_count; slot-- > 0;) {
+        if (!_bodies[_storage.entity[slot]].is_sleeping) continue;
+        swap_slots(slot, --_storage.awake_count);
+    }
+}
+
+auto physics::wake(entity_id const entity) -> void {
+    if (entity >= _bodies.size() || !_bodies[entity].is_sleeping) return;
+
+    auto const island = _bodies[entity].island;
+    for (auto member : _sleeping_islands[island]) {
+        auto& state = _bodies[member];
+        if (!state.is_sleeping) continue; // removed while asleep
+
+        state.is_sleeping = false;
+        state.sleep_time = real{0};
+
+        swap_slots(state.slot, _storage.awake_count++);
+        _storage.load(state.slot, _scene->get_component<physics_body_component>(member));
+    }
+
+    _sleeping_islands[island].clear();
+    _free_islands.push_back(island);
 }
 
 }
\ No newline at end of file
@@ -2,7 +2,13 @@
 #define ENGINE_PHYSICS_PHYSICS_H
 
 #include <physics/types.h>
+#include <physics/broadphase.h>
+#include <physics/body_storage.h>
+#include <physics/shapes.h>
+#include <physics/contact_solver.h>
+#include <physics/tile_colliders.h>
 #include <scene/scene.h>
+#include <core/thread_pool.h>
 
 namespace xc {
 
@@ -10,19 +16,148 @@ class physics {
 public:
     ~physics();
 
-    auto static create(std::shared_ptr<xc::scene> scene) -> std::shared_ptr<physics>;
+    // Steps are split over `worker_count` threads besides the caller's; the result is the same for any count
+    auto static create(std::shared_ptr<xc::scene> scene, broadphase_type type, float cell_size,
+                       std::uint32_t worker_count = thread_pool::default_worker_count()) -> std::shared_ptr<physics>;
 
     auto create_body(vector2 const& position, float radius, bool is_dynamic = true) -> physics_body_component;
 
+    // Other shapes, at the same density as circles. Boxes never rotate. Polygon vertices are relative to
+    // the position, which should lie inside them; the polygon stays registered for the life of the world.
+    auto create_box(vector2 const& position, vector2 const& half_extents, bool is_dynamic = true) -> physics_body_component;
+    auto create_capsule(vector2 const& position, float half_length, float radius, bool is_dynamic = true) -> physics_body_component;
+    auto create_polygon(vector2 const& position, std::span<vector2 const> vertices, bool is_dynamic = true) -> physics_body_component;
+
     auto add_force(entity_id entity, vector2 const& force) -> void;
 
+    // Static level geometry from a row-major tile grid where zero is empty. Solid tiles are merged into
+    // boxes chunk by chunk and kept in a tree of their own, so a wall costs a few tests rather than one per tile.
+    auto add_tile_layer(std::span<std::int64_t const> cells, std::uint32_t columns, std::uint32_t rows,
+                        float tile_size, vector2 const& origin, std::uint32_t category = 1) -> void;
+    auto clear_tiles() -> void;
+
     auto tick(float step) -> void;
 
+    // The body's pose `alpha` of the way from the start to the end of the last tick. Rendering with the
+    // accumulator's leftover fraction of a step keeps motion smooth whatever the simulation rate.
+    auto interpolated_pose(entity_id entity, float alpha) const -> pose;
+
+    // Queries against body positions as of the last tick and against the tile walls, considering only
+    // bodies and tiles whose category is in `mask`. Walls are reported as TILE_ENTITY, and only once
+    // however many they overlap. Overlaps are appended to the caller's buffer.
+    auto raycast(vector2 const& from, vector2 const& to, raycast_hit& hit, std::uint32_t mask = ~0u) -> bool;
+    auto overlap_circle(vector2 const& center, float radius, std::vector<entity_id>& entities, std::uint32_t mask = ~0u) -> void;
+    auto overlap_aabb(aabb const& bounds, std::vector<entity_id>& entities, std::uint32_t mask = ~0u) -> void;
+    auto nearest(vector2 const& point, float max_distance, entity_id& entity, std::uint32_t mask = ~0u) -> bool;
+
+    auto stats() const -> physics_stats const& { return _stats; }
+
+    // Complete simulation state between ticks: bodies and their components, contact cache, touching pairs,
+    // sleeping islands, tiles and every broadphase. Saving into the same buffer each frame reuses its memory.
+    // Restoring expects the scene to hold the same body entities it did when saved, as a rollback of the
+    // scene would; any that differ are added or removed on the next tick.
+    auto save(std::vector<std::byte>& buffer) const -> void;
+    auto restore(std::span<std::byte const> buffer) -> void;
+
+    // Pairs that started touching, kept touching or separated during the last tick, ordered by pair
+    auto contact_events() const -> std::vector<contact_event> const& { return _contact_events; }
+
 private:
-    physics(std::shared_ptr<xc::scene> scene);
+    physics(std::shared_ptr<xc::scene> scene, broadphase_type type, float cell_size, std::uint32_t worker_count);
+
+    // Bookkeeping the scene doesn't need to see
+    struct body_state {
+        proxy_id proxy = null_proxy;
+        std::uint32_t slot = 0;   // index into _storage
+        bool is_static = false, is_sensor = false, is_bullet = false, is_sleeping = false;
+        std::uint32_t category = 0, mask = 0;
+        real sleep_time = real{0};
+        std::uint32_t island = 0; // index into _sleeping_islands while asleep
+    };
+
+    auto sync_bodies(std::vector<entity_id> body_entities, std::vector<physics_body_component>& components) -> void;
+    auto add_body(entity_id entity, physics_body_component const& body) -> void;
+    auto remove_body(entity_id entity) -> void;
+    auto swap_slots(std::uint32_t a, std::uint32_t b) -> void;
+    auto broadphase_of(body_state const& state) const -> broadphase&;
+    auto bounds_of(std::uint32_t slot) const -> aabb;
+    auto shape_at(std::uint32_t slot) const -> world_shape;
+    template<class F> auto query_bodies(std::uint32_t mask, F&& query) -> void;
 
-    vector2 _gravity;
+    auto should_collide(entity_id a, entity_id b) const -> bool;
+    auto find_pairs() -> void;
+    auto collide_pairs() -> void;
+    auto collide_tiles() -> void;
+    auto update_contact_events() -> void;
+    auto find_fast_bodies(real step) -> void;
+    auto sweep_fast_bodies(real step) -> void;
+    auto update_sleep(real step, std::vector<physics_body_component>& components) -> void;
+    auto wake(entity_id entity) -> void;
+
+    real2 _gravity;
     std::shared_ptr<xc::scene> _scene;
+
+    // Static bodies and sensors never move and are never paired with each other, so each kind lives in
+    // its own tree that only awake dynamic bodies query
+    std::shared_ptr<broadphase> _dynamic_broadphase, _static_broadphase, _sensor_broadphase;
+    std::uint32_t _static_categories = 0, _sensor_categories = 0; // unions over every body ever added
+
+    // Merged tile boxes, indexed by the id their proxy carries
+    struct tile_box {
+        aabb bounds;
+        std::uint32_t category;
+        proxy_id proxy;
+    };
+
+    std::shared_ptr<broadphase> _tile_broadphase;
+    std::vector<tile_box> _tiles;
+    std::vector<aabb> _merged_tiles;
+    std::uint32_t _tile_categories = 0;
+
+    // Awake bodies against tiles. Pairs are (entity, tile) and contacts (entity, TILE_KEY | tile), which
+    // sorts them after the body's own pairs and keeps the solver's cache keys apart.
+    std::vector<body_pair> _tile_pairs;
+    std::vector<contact> _tile_contacts;
+    std::vector<entity_id> _tile_results;
+
+    // Simulation state lives here for the duration of a step; components are loaded before and stored after
+    body_storage _storage;
+    std::vector<convex_polygon> _polygons;
+
+    std::vector<body_state> _bodies; // indexed by entity
+    std::vector<entity_id> _body_entities, _query_results;
+    std::vector<body_pair> _pairs;
+    std::vector<std::uint32_t> _pair_slots_a, _pair_slots_b;
+    std::vector<std::size_t> _chunk_contact_counts;
+    std::vector<contact> _contacts;
+
+    // Bodies that move further than their radius in a step, swept after integration so they can't tunnel
+    struct fast_body {
+        std::uint32_t slot;
+        real2 start, velocity;
+    };
+
+    struct swept_sensor {
+        entity_id entity;
+        real time;
+    };
+
+    std::vector<fast_body> _fast_bodies;
+    std::vector<swept_sensor> _swept_sensors;
+
+    // Touching pairs from the last tick, sorted, diffed against this tick's contacts plus any sensors that
+    // fast bodies swept through
+    std::vector<body_pair> _touching, _next_touching, _event_pairs, _swept_pairs;
+    std::vector<contact_event> _contact_events;
+
+    contact_solver _solver;
+    thread_pool _workers;
+
+    physics_stats _stats{};
+
+    std::vector<std::vector<entity_id>> _sleeping_islands;
+    std::vector<std::uint32_t> _free_islands, _island_parents, _island_slots;
+    std::vector<real> _island_sleep_time;
 };
 
 }
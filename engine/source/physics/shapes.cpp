@@ -0,0 +1,456 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "shapes.h"
+
+#include <physics/narrowphase.h>
+
+namespace xc {
+
+// Incident vertices this close in depth are treated as one flat face touching the reference face
+auto static constexpr FLAT_TOLERANCE = real{0.25f};
+
+using collide_function = auto (*)(world_shape const& a, world_shape const& b, contact& result) -> bool;
+
+// Fixed-point builds find their own integer sin and cos, so turning shapes stay bit-identical too
+auto static rotation_of(real const angle) -> real2 {
+    using std::cos, std::sin;
+    return {cos(angle), sin(angle)};
+}
+
+auto static rotate(real2 const& v, real2 const& rotation) -> real2 {
+    return {rotation.x * v.x - rotation.y * v.y, rotation.y * v.x + rotation.x * v.y};
+}
+
+auto static negate(real2 const& v) -> real2 { return {-v.x, -v.y}; }
+
+auto static closest_on_segment(real2 const& point, real2 const& a, real2 const& b) -> real2 {
+    auto const ab = b - a;
+    auto const length = length_sq(ab);
+    if (length == real{0}) return a;
+
+    return a + ab * std::clamp(dot(point - a, ab) / length, real{0}, real{1});
+}
+
+// Closest points between segments p1-q1 and p2-q2 (Ericson, Real-Time Collision Detection 5.1.9)
+auto static closest_between_segments(real2 const& p1, real2 const& q1, real2 const& p2, real2 const& q2, real2& c1, real2& c2) -> void {
+    auto const d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    auto const a = dot(d1, d1), e = dot(d2, d2), f = dot(d2, r);
+    auto s = real{0}, t = real{0};
+
+    if (a == real{0} && e == real{0}) {
+        // Both are points
+    } else if (a == real{0}) {
+        t = std::clamp(f / e, real{0}, real{1});
+    } else {
+        auto const c = dot(d1, r);
+        if (e == real{0}) {
+            s = std::clamp(-c / a, real{0}, real{1});
+        } else {
+            auto const b = dot(d1, d2);
+            auto const denominator = a * e - b * b;
+            s = denominator != real{0} ? std::clamp((b * f - c * e) / denominator, real{0}, real{1}) : real{0};
+            t = (b * s + f) / e;
+
+            if (t < real{0}) {
+                t = real{0};
+                s = std::clamp(-c / a, real{0}, real{1});
+            } else if (t > real{1}) {
+                t = real{1};
+                s = std::clamp((b - c) / a, real{0}, real{1});
+            }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+}
+
+// Two rounded points: `radius` is both radii together
+auto static collide_points(real2 const& a, real2 const& b, real const radius_a, real const radius, contact& result) -> bool {
+    auto const delta = b - a;
+    auto const distance_sq = length_sq(delta);
+    if (distance_sq >= radius * radius) return false;
+
+    auto const distance = sqrt(distance_sq);
+    if (distance == real{0}) {
+        result.normal = real2{real{1}, real{0}};
+        result.penetration = radius;
+        result.point = a;
+    } else {
+        result.normal = delta / distance;
+        result.penetration = radius - distance;
+        result.point = result.normal * (radius_a - result.penetration * real{0.5f}) + a;
+    }
+
+    return true;
+}
+
+auto static last_vertex(world_shape const& shape) -> real2 const& { return shape.vertices[shape.count - 1]; }
+
+// Faces the separating axis test tries: a polygon's edges, both sides of a segment, none for a point
+auto static face_count(world_shape const& shape) -> std::uint32_t {
+    return shape.count >= 3 ? shape.count : (shape.count == 2 ? 2 : 0);
+}
+
+auto static face_vertex(world_shape const& shape, std::uint32_t const face) -> real2 const& {
+    return shape.count >= 3 ? shape.vertices[face] : shape.vertices[0];
+}
+
+auto static edge_count(world_shape const& shape) -> std::uint32_t { return shape.count >= 3 ? shape.count : 1; }
+
+auto static edge_end(world_shape const& shape, std::uint32_t const edge) -> real2 const& {
+    return shape.count >= 3 ? shape.vertices[(edge + 1) % shape.count] : last_vertex(shape);
+}
+
+auto static collide_circle_circle(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    return collide_points(a.vertices[0], b.vertices[0], a.radius, a.radius + b.radius, result);
+}
+
+// Circles and capsules: the closest points of the two cores, then as circles
+auto static collide_segments(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    auto closest_a = real2{}, closest_b = real2{};
+    closest_between_segments(a.vertices[0], last_vertex(a), b.vertices[0], last_vertex(b), closest_a, closest_b);
+    return collide_points(closest_a, closest_b, a.radius, a.radius + b.radius, result);
+}
+
+auto static collide_circle_box(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    return collide_circle_box(a.vertices[0], a.radius, b.vertices[0], b.vertices[2], result);
+}
+
+auto static collide_boxes(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    auto const& min_a = a.vertices[0], max_a = a.vertices[2];
+    auto const& min_b = b.vertices[0], max_b = b.vertices[2];
+
+    auto const low = real2{std::max(min_a.x, min_b.x), std::max(min_a.y, min_b.y)};
+    auto const high = real2{std::min(max_a.x, max_b.x), std::min(max_a.y, max_b.y)};
+    auto const overlap = high - low;
+    if (overlap.x <= real{0} || overlap.y <= real{0}) return false;
+
+    // Out along the shallower axis, towards b
+    auto const delta = (min_b + max_b) - (min_a + max_a);
+    if (overlap.x < overlap.y) {
+        result.normal = real2{delta.x < real{0} ? real{-1} : real{1}, real{0}};
+        result.penetration = overlap.x;
+    } else {
+        result.normal = real2{real{0}, delta.y < real{0} ? real{-1} : real{1}};
+        result.penetration = overlap.y;
+    }
+
+    result.point = (low + high) * real{0.5f};
+    return true;
+}
+
+// Separating axes over both shapes' faces. Overlapping cores push out along the axis of least overlap,
+// from the middle of the incident feature clipped to the reference face. Cores that are apart but within
+// the radii touch between their closest vertex and edge, or along a face if they lie flat against it.
+auto static collide_polygons(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    auto const radius = a.radius + b.radius;
+
+    auto found = false;
+    auto separation = real{0};
+    auto reference_is_a = true;
+    auto reference_face = std::uint32_t{0};
+
+    auto const test_faces = [&](world_shape const& reference, world_shape const& incident, bool const is_a) {
+        for (auto face = std::uint32_t{0}; face < face_count(reference); ++face) {
+            auto const& normal = reference.normals[face];
+            auto const& origin = face_vertex(reference, face);
+
+            auto face_separation = dot(normal, incident.vertices[0] - origin);
+            for (auto i = std::uint32_t{1}; i < incident.count; ++i)
+                face_separation = std::min(face_separation, dot(normal, incident.vertices[i] - origin));
+
+            if (!found || face_separation > separation) {
+                found = true;
+                separation = face_separation;
+                reference_is_a = is_a;
+                reference_face = face;
+            }
+        }
+    };
+
+    test_faces(a, b, true);
+    test_faces(b, a, false);
+    if (separation > radius) return false;
+
+    if (separation > real{0}) {
+        if (radius == real{0}) return false;
+
+        auto best = real{0};
+        auto closest_a = real2{}, closest_b = real2{};
+        auto any = false;
+
+        auto const test_vertices = [&](world_shape const& vertices, world_shape const& edges, bool const vertices_are_a) {
+            for (auto i = std::uint32_t{0}; i < vertices.count; ++i) {
+                for (auto edge = std::uint32_t{0}; edge < edge_count(edges); ++edge) {
+                    auto const on_edge = closest_on_segment(vertices.vertices[i], edges.vertices[edge], edge_end(edges, edge));
+                    auto const distance = length_sq(on_edge - vertices.vertices[i]);
+                    if (any && distance >= best) continue;
+
+                    any = true;
+                    best = distance;
+                    closest_a = vertices_are_a ? vertices.vertices[i] : on_edge;
+                    closest_b = vertices_are_a ? on_edge : vertices.vertices[i];
+                }
+            }
+        };
+
+        test_vertices(a, b, true);
+        test_vertices(b, a, false);
+
+        auto const distance = sqrt(best);
+        if (distance >= radius) return false;
+
+        // Cores that are closest at a corner touch there; one lying along a face is handled like an overlap
+        // below, so a capsule resting on a box pushes from the middle of its flat side
+        if (distance - separation > FLAT_TOLERANCE) return collide_points(closest_a, closest_b, a.radius, radius, result);
+        separation = distance;
+    }
+
+    auto const& reference = reference_is_a ? a : b;
+    auto const& incident = reference_is_a ? b : a;
+    auto const& normal = reference.normals[reference_face];
+    auto const& origin = face_vertex(reference, reference_face);
+
+    // Deepest incident vertex, and a neighbour about as deep if the incident side lies flat on the face
+    auto const depth = [&](std::uint32_t const i) { return dot(normal, incident.vertices[i] - origin); };
+
+    auto deepest = std::uint32_t{0};
+    for (auto i = std::uint32_t{1}; i < incident.count; ++i)
+        if (depth(i) < depth(deepest)) deepest = i;
+
+    auto partner = deepest;
+    if (incident.count >= 2) {
+        auto const next = (deepest + 1) % incident.count;
+        auto const previous = (deepest + incident.count - 1) % incident.count;
+        if (abs(depth(next) - depth(deepest)) <= FLAT_TOLERANCE) partner = next;
+        else if (abs(depth(previous) - depth(deepest)) <= FLAT_TOLERANCE) partner = previous;
+    }
+
+    auto const face_start = origin;
+    auto const face_end = reference.count >= 3 ? reference.vertices[(reference_face + 1) % reference.count] : last_vertex(reference);
+    // Slide a vertex along the face until it lies within the face's extent, keeping its depth
+    auto const clip = [&](real2 const& point) {
+        return closest_on_segment(point, face_start, face_end) + normal * dot(normal, point - face_start);
+    };
+
+    auto const incident_point = (clip(incident.vertices[deepest]) + clip(incident.vertices[partner])) * real{0.5f};
+
+    result.penetration = radius - separation;
+    result.normal = reference_is_a ? normal : negate(normal);
+    result.point = incident_point - normal * (incident.radius - result.penetration * real{0.5f});
+    return true;
+}
+
+template<collide_function F> auto static flipped(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    if (!F(b, a, result)) return false;
+
+    result.normal = negate(result.normal);
+    return true;
+}
+
+// Indexed [a][b] by shape_type: circle, capsule, box, polygon
+auto static constexpr COLLIDE_TABLE = std::array<std::array<collide_function, 4>, 4>{{
+    {collide_circle_circle,               collide_segments,  collide_circle_box, collide_polygons},
+    {collide_segments,                    collide_segments,  collide_polygons,   collide_polygons},
+    {flipped<collide_circle_box>,         collide_polygons,  collide_boxes,      collide_polygons},
+    {collide_polygons,                    collide_polygons,  collide_polygons,   collide_polygons},
+}};
+
+auto collide_shapes(world_shape const& a, world_shape const& b, contact& result) -> bool {
+    return COLLIDE_TABLE[static_cast<std::size_t>(a.type)][static_cast<std::size_t>(b.type)](a, b, result);
+}
+
+auto circle_shape(real2 const& center, real const radius) -> world_shape {
+    auto shape = world_shape{};
+    shape.type = shape_type::eCircle;
+    shape.count = 1;
+    shape.vertices[0] = center;
+    shape.radius = radius;
+    return shape;
+}
+
+auto box_shape(real2 const& min, real2 const& max) -> world_shape {
+    auto shape = world_shape{};
+    shape.type = shape_type::eBox;
+    shape.count = 4;
+    shape.vertices[0] = min;
+    shape.vertices[1] = real2{max.x, min.y};
+    shape.vertices[2] = max;
+    shape.vertices[3] = real2{min.x, max.y};
+    shape.normals[0] = real2{real{0}, real{-1}};
+    shape.normals[1] = real2{real{1}, real{0}};
+    shape.normals[2] = real2{real{0}, real{1}};
+    shape.normals[3] = real2{real{-1}, real{0}};
+    shape.radius = real{0};
+    return shape;
+}
+
+auto shape_of(body_storage const& bodies, std::span<convex_polygon const> polygons, std::uint32_t const slot) -> world_shape {
+    auto const position = bodies.position(slot);
+
+    switch (bodies.shape[slot]) {
+        case shape_type::eCapsule: {
+            auto const rotation = rotation_of(bodies.rotation[slot]);
+
+            auto shape = world_shape{};
+            shape.type = shape_type::eCapsule;
+            shape.count = 2;
+            shape.vertices[0] = position - rotation * bodies.extent_x[slot];
+            shape.vertices[1] = position + rotation * bodies.extent_x[slot];
+            shape.normals[0] = real2{-rotation.y, rotation.x};
+            shape.normals[1] = real2{rotation.y, -rotation.x};
+            shape.radius = bodies.radius[slot];
+            return shape;
+        }
+        case shape_type::eBox: {
+            auto const extents = real2{bodies.extent_x[slot], bodies.extent_y[slot]};
+            return box_shape(position - extents, position + extents);
+        }
+        case shape_type::ePolygon: {
+            auto const& polygon = polygons[bodies.polygon[slot]];
+            auto const rotation = rotation_of(bodies.rotation[slot]);
+
+            auto shape = world_shape{};
+            shape.type = shape_type::ePolygon;
+            shape.count = polygon.count;
+            for (auto i = std::uint32_t{0}; i < polygon.count; ++i) {
+                shape.vertices[i] = position + rotate(polygon.vertices[i], rotation);
+                shape.normals[i] = rotate(polygon.normals[i], rotation);
+            }
+            shape.radius = real{0};
+            return shape;
+        }
+        default:
+            return circle_shape(position, bodies.radius[slot]);
+    }
+}
+
+auto shape_bounds(world_shape const& shape) -> aabb {
+    auto min = shape.vertices[0], max = shape.vertices[0];
+    for (auto i = std::uint32_t{1}; i < shape.count; ++i) {
+        min = real2{std::min(min.x, shape.vertices[i].x), std::min(min.y, shape.vertices[i].y)};
+        max = real2{std::max(max.x, shape.vertices[i].x), std::max(max.y, shape.vertices[i].y)};
+    }
+
+    auto const radius = static_cast<float>(shape.radius);
+    return {to_vector2(min) - radius, to_vector2(max) + radius};
+}
+
+auto inner_radius(body_storage const& bodies, std::span<convex_polygon const> polygons, std::uint32_t const slot) -> real {
+    switch (bodies.shape[slot]) {
+        case shape_type::eBox: return std::min(bodies.extent_x[slot], bodies.extent_y[slot]);
+        case shape_type::ePolygon: return polygons[bodies.polygon[slot]].inner_radius;
+        default: return bodies.radius[slot];
+    }
+}
+
+// Cyrus-Beck: the ray clipped by each face plane in turn, the planes pushed out by `offset`
+auto static clip_ray(std::span<real2 const> origins, std::span<real2 const> normals, real const offset,
+                     real2 const& start, real2 const& delta, real2& normal) -> real {
+    auto constexpr miss = real{2};
+    auto enter = real{0}, exit = real{1};
+    auto entered = false;
+
+    for (auto face = std::size_t{0}; face < normals.size(); ++face) {
+        auto const distance = dot(normals[face], origins[face] - start) + offset;
+        auto const speed = dot(normals[face], delta);
+
+        if (speed == real{0}) {
+            if (distance < real{0}) return miss;
+        } else if (speed < real{0}) {
+            auto const t = distance / speed;
+            if (t > enter || !entered) {
+                enter = std::max(enter, t);
+                normal = normals[face];
+                entered = true;
+            }
+        } else {
+            exit = std::min(exit, distance / speed);
+        }
+
+        if (enter > exit) return miss;
+    }
+
+    return entered ? enter : miss;
+}
+
+auto raycast_shape(world_shape const& shape, real2 const& start, real2 const& delta, real2& normal) -> real {
+    auto constexpr miss = real{2};
+    if (shape_distance(shape, start) == real{0}) return miss;
+
+    if (shape.count >= 3)
+        return clip_ray(std::span{shape.vertices}.first(shape.count), std::span{shape.normals}.first(shape.count), shape.radius, start, delta, normal);
+
+    // Rounded point or segment: the end circles, then the sides of a capsule
+    auto best = miss;
+    for (auto const& center : {shape.vertices[0], last_vertex(shape)}) {
+        auto const t = time_of_impact(start, delta, real{0}, center, shape.radius);
+        if (t > real{1} || t >= best) continue;
+
+        best = t;
+        normal = normalize(start + delta * t - center);
+    }
+
+    auto const axis = last_vertex(shape) - shape.vertices[0];
+    if (shape.count == 2 && length_sq(axis) > real{0}) {
+        auto const direction = normalize(axis);
+        auto const& side = shape.normals[0];
+
+        auto const origins = std::array{shape.vertices[0] + side * shape.radius, shape.vertices[0] - side * shape.radius, last_vertex(shape), shape.vertices[0]};
+        auto const normals = std::array{side, negate(side), direction, negate(direction)};
+
+        auto side_normal = real2{};
+        auto const t = clip_ray(origins, normals, real{0}, start, delta, side_normal);
+        if (t <= real{1} && t < best) {
+            best = t;
+            normal = side_normal;
+        }
+    }
+
+    return best;
+}
+
+auto shape_distance(world_shape const& shape, real2 const& point) -> real {
+    if (shape.count < 3) {
+        auto const distance = length(point - closest_on_segment(point, shape.vertices[0], last_vertex(shape))) - shape.radius;
+        return std::max(distance, real{0});
+    }
+
+    auto inside = true;
+    for (auto face = std::uint32_t{0}; face < shape.count && inside; ++face)
+        inside = dot(shape.normals[face], point - shape.vertices[face]) <= real{0};
+    if (inside) return real{0};
+
+    auto best = length_sq(point - closest_on_segment(point, shape.vertices[0], shape.vertices[1]));
+    for (auto edge = std::uint32_t{1}; edge < shape.count; ++edge)
+        best = std::min(best, length_sq(point - closest_on_segment(point, shape.vertices[edge], edge_end(shape, edge))));
+
+    return std::max(sqrt(best) - shape.radius, real{0});
+}
+
+auto make_polygon(std::span<vector2 const> vertices) -> convex_polygon {
+    auto polygon = convex_polygon{};
+    polygon.count = static_cast<std::uint32_t>(std::min<std::size_t>(vertices.size(), MAX_POLYGON_VERTICES));
+
+    for (auto i = std::uint32_t{0}; i < polygon.count; ++i) polygon.vertices[i] = to_real2(vertices[i]);
+
+    // Wind so that (edge.y, -edge.x) faces out
+    auto area = real{0};
+    for (auto i = std::uint32_t{0}; i < polygon.count; ++i)
+        area += cross(polygon.vertices[i], polygon.vertices[(i + 1) % polygon.count]);
+    if (area < real{0}) std::reverse(polygon.vertices.begin(), polygon.vertices.begin() + polygon.count);
+
+    for (auto i = std::uint32_t{0}; i < polygon.count; ++i) {
+        auto const edge = polygon.vertices[(i + 1) % polygon.count] - polygon.vertices[i];
+        polygon.normals[i] = normalize(real2{edge.y, -edge.x});
+
+        auto const distance = std::max(dot(polygon.normals[i], polygon.vertices[i]), real{0});
+        polygon.inner_radius = i == 0 ? distance : std::min(polygon.inner_radius, distance);
+    }
+
+    return polygon;
+}
+
+}
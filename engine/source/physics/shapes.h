@@ -0,0 +1,45 @@
+#ifndef ENGINE_PHYSICS_SHAPES_H
+#define ENGINE_PHYSICS_SHAPES_H
+
+#include <physics/body_storage.h>
+
+#include <span>
+
+namespace xc {
+
+// Every shape is handled as a convex core (a point, a segment or a polygon) grown by a radius: circles
+// are a rounded point, capsules a rounded segment, and boxes and polygons have no rounding
+struct world_shape {
+    shape_type type;
+    std::uint32_t count;                                    // core vertices: 1, 2 or at least 3
+    std::array<real2, MAX_POLYGON_VERTICES> vertices, normals; // outward face normals; both sides of a segment
+    real radius;
+};
+
+auto shape_of(body_storage const& bodies, std::span<convex_polygon const> polygons, std::uint32_t slot) -> world_shape;
+auto circle_shape(real2 const& center, real radius) -> world_shape;
+auto box_shape(real2 const& min, real2 const& max) -> world_shape;
+
+auto shape_bounds(world_shape const& shape) -> aabb;
+
+// Radius of the largest circle about the body's position that fits inside its shape; continuous collision
+// sweeps bodies as this circle
+auto inner_radius(body_storage const& bodies, std::span<convex_polygon const> polygons, std::uint32_t slot) -> real;
+
+// Fills everything but the contact's pair. The routine comes from a table indexed by both shape types.
+auto collide_shapes(world_shape const& a, world_shape const& b, contact& result) -> bool;
+
+// Fraction along `delta` at which a ray from `start` enters the shape, or anything above one if it doesn't;
+// rays starting inside miss. Growing a shape's radius by a circle's turns this into that circle's sweep, though
+// a rounded polygon keeps sharp corners and so is hit a little early there.
+auto raycast_shape(world_shape const& shape, real2 const& start, real2 const& delta, real2& normal) -> real;
+
+// From the point to the shape's surface, zero inside
+auto shape_distance(world_shape const& shape, real2 const& point) -> real;
+
+// Outward normals, inner radius and counter-clockwise order for up to MAX_POLYGON_VERTICES convex vertices
+auto make_polygon(std::span<vector2 const> vertices) -> convex_polygon;
+
+}
+
+#endif // ENGINE_PHYSICS_SHAPES_H
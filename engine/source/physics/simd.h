@@ -0,0 +1,71 @@
+#ifndef ENGINE_PHYSICS_SIMD_H
+#define ENGINE_PHYSICS_SIMD_H
+
+#include <core/types.h>
+
+// Thin wrappers so the physics kernels are written once for whichever vector width the compiler targets:
+// 8 lanes with AVX2, 4 with SSE2 (every x86-64 build). PHYSICS_SIMD is left undefined elsewhere, and in
+// fixed-point builds, and the kernels fall back to their scalar loops.
+#if PHYSICS_FIXED_POINT
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define PHYSICS_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PHYSICS_SIMD
+#endif
+
+namespace xc {
+
+#if PHYSICS_FIXED_POINT
+#elif defined(__AVX2__)
+
+using lane = __m256;
+auto static constexpr LANE_WIDTH = std::uint32_t{8};
+
+auto inline lane_load(float const* source) -> lane { return _mm256_loadu_ps(source); }
+auto inline lane_store(float* destination, lane value) -> void { _mm256_storeu_ps(destination, value); }
+auto inline lane_set(float value) -> lane { return _mm256_set1_ps(value); }
+auto inline lane_add(lane a, lane b) -> lane { return _mm256_add_ps(a, b); }
+auto inline lane_sub(lane a, lane b) -> lane { return _mm256_sub_ps(a, b); }
+auto inline lane_mul(lane a, lane b) -> lane { return _mm256_mul_ps(a, b); }
+auto inline lane_div(lane a, lane b) -> lane { return _mm256_div_ps(a, b); }
+auto inline lane_sqrt(lane a) -> lane { return _mm256_sqrt_ps(a); }
+auto inline lane_min(lane a, lane b) -> lane { return _mm256_min_ps(a, b); }
+auto inline lane_max(lane a, lane b) -> lane { return _mm256_max_ps(a, b); }
+auto inline lane_less(lane a, lane b) -> lane { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+auto inline lane_select(lane mask, lane a, lane b) -> lane { return _mm256_blendv_ps(b, a, mask); }
+auto inline lane_mask_bits(lane mask) -> int { return _mm256_movemask_ps(mask); }
+
+auto inline lane_gather(float const* base, std::uint32_t const* indices) -> lane {
+    return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<__m256i const*>(indices)), 4);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+using lane = __m128;
+auto static constexpr LANE_WIDTH = std::uint32_t{4};
+
+auto inline lane_load(float const* source) -> lane { return _mm_loadu_ps(source); }
+auto inline lane_store(float* destination, lane value) -> void { _mm_storeu_ps(destination, value); }
+auto inline lane_set(float value) -> lane { return _mm_set1_ps(value); }
+auto inline lane_add(lane a, lane b) -> lane { return _mm_add_ps(a, b); }
+auto inline lane_sub(lane a, lane b) -> lane { return _mm_sub_ps(a, b); }
+auto inline lane_mul(lane a, lane b) -> lane { return _mm_mul_ps(a, b); }
+auto inline lane_div(lane a, lane b) -> lane { return _mm_div_ps(a, b); }
+auto inline lane_sqrt(lane a) -> lane { return _mm_sqrt_ps(a); }
+auto inline lane_min(lane a, lane b) -> lane { return _mm_min_ps(a, b); }
+auto inline lane_max(lane a, lane b) -> lane { return _mm_max_ps(a, b); }
+auto inline lane_less(lane a, lane b) -> lane { return _mm_cmplt_ps(a, b); }
+auto inline lane_select(lane mask, lane a, lane b) -> lane { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+auto inline lane_mask_bits(lane mask) -> int { return _mm_movemask_ps(mask); }
+
+auto inline lane_gather(float const* base, std::uint32_t const* indices) -> lane {
+    return _mm_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]);
+}
+
+#endif
+
+}
+
+#endif // ENGINE_PHYSICS_SIMD_H
@@ -0,0 +1,66 @@
+#ifndef ENGINE_PHYSICS_SNAPSHOT_H
+#define ENGINE_PHYSICS_SNAPSHOT_H
+
+#include <core/types.h>
+
+#include <span>
+#include <cstring>
+
+namespace xc {
+
+// Byte image of physics state for rollback and replays. Values are copied exactly as they sit in memory,
+// so a snapshot only restores into the same build on the same platform, which is all rollback needs.
+class snapshot_writer {
+public:
+    explicit snapshot_writer(std::vector<std::byte>& buffer) : _buffer{buffer} {}
+
+    template<class T> requires std::is_trivially_copyable_v<T> auto write(T const& value) -> void {
+        append(&value, sizeof(T));
+    }
+
+    template<class T> requires std::is_trivially_copyable_v<T> auto write(std::vector<T> const& values) -> void {
+        write(values.size());
+        append(values.data(), values.size() * sizeof(T));
+    }
+
+private:
+    auto append(void const* data, std::size_t const size) -> void {
+        auto const offset = _buffer.size();
+        _buffer.resize(offset + size);
+        if (size) std::memcpy(_buffer.data() + offset, data, size);
+    }
+
+    std::vector<std::byte>& _buffer;
+};
+
+class snapshot_reader {
+public:
+    explicit snapshot_reader(std::span<std::byte const> buffer) : _buffer{buffer} {}
+
+    template<class T> requires std::is_trivially_copyable_v<T> auto read(T& value) -> void {
+        take(&value, sizeof(T));
+    }
+
+    template<class T> requires std::is_trivially_copyable_v<T> auto read(std::vector<T>& values) -> void {
+        auto size = std::size_t{0};
+        read(size);
+        if (size > (_buffer.size() - _offset) / sizeof(T)) throw std::runtime_error("Truncated physics snapshot");
+
+        values.resize(size);
+        take(values.data(), size * sizeof(T));
+    }
+
+private:
+    auto take(void* data, std::size_t const size) -> void {
+        if (size > _buffer.size() - _offset) throw std::runtime_error("Truncated physics snapshot");
+        if (size) std::memcpy(data, _buffer.data() + _offset, size);
+        _offset += size;
+    }
+
+    std::span<std::byte const> _buffer;
+    std::size_t _offset = 0;
+};
+
+}
+
+#endif // ENGINE_PHYSICS_SNAPSHOT_H
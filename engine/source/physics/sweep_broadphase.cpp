@@ -0,0 +1,304 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "sweep_broadphase.h"
+
+#include <algorithm>
+
+namespace xc {
+
+sweep_broadphase::sweep_broadphase() = default;
+
+auto sweep_broadphase::value_of(aabb const& bounds, std::size_t const axis, bool const is_max) -> float {
+    auto const& corner = is_max ? bounds.max : bounds.min;
+    return axis == 0 ? corner.x : corner.y;
+}
+
+auto sweep_broadphase::create_proxy(aabb const& bounds, entity_id const entity) -> proxy_id {
+    auto proxy = proxy_id{0};
+
+    if (!_free_proxies.empty()) {
+        proxy = _free_proxies.back();
+        _free_proxies.pop_back();
+    } else {
+        proxy = static_cast<proxy_id>(_proxies.size());
+        _proxies.emplace_back();
+
+        // Room for a typical pile up front, so pairs beginning mid-step rarely allocate
+        _partners.emplace_back().reserve(INITIAL_PARTNERS);
+    }
+
+    _proxies[proxy].bounds = bounds;
+    _proxies[proxy].entity = entity;
+    _proxies[proxy].in_use = true;
+    _proxies[proxy].pending = true;
+
+    _pending_proxies.push_back(proxy);
+
+    return proxy;
+}
+
+auto sweep_broadphase::destroy_proxy(proxy_id const proxy) -> void {
+    _proxies[proxy].in_use = false;
+    _free_proxies.push_back(proxy);
+
+    // Never made it into the endpoint lists
+    if (_proxies[proxy].pending) {
+        _proxies[proxy].pending = false;
+        return;
+    }
+
+    while (!_partners[proxy].empty()) remove_pair(proxy, _partners[proxy].back());
+
+    // Left in place until the next update, so destroying many proxies costs one pass over the lists
+    for (auto axis = std::size_t{0}; axis < 2; ++axis) {
+        _endpoints[axis][_proxies[proxy].min_index[axis]].proxy = DEAD_PROXY;
+        _endpoints[axis][_proxies[proxy].max_index[axis]].proxy = DEAD_PROXY;
+    }
+    _dead_endpoints += 2;
+}
+
+auto sweep_broadphase::move_proxy(proxy_id const proxy, aabb const& bounds, vector2 const&) -> void {
+    auto const old_bounds = _proxies[proxy].bounds;
+    _proxies[proxy].bounds = bounds;
+
+    if (_proxies[proxy].pending) return;
+
+    for (auto axis = std::size_t{0}; axis < 2; ++axis) {
+        auto const min_index = _proxies[proxy].min_index[axis];
+        auto const max_index = _proxies[proxy].max_index[axis];
+
+        auto const min_delta = value_of(bounds, axis, false) - value_of(old_bounds, axis, false);
+        auto const max_delta = value_of(bounds, axis, true) - value_of(old_bounds, axis, true);
+
+        _endpoints[axis][min_index].value = value_of(bounds, axis, false);
+        _endpoints[axis][max_index].value = value_of(bounds, axis, true);
+
+        // Grow before shrinking so the proxy never passes over itself
+        if (min_delta < 0.f) sort_down(axis, min_index);
+        if (max_delta > 0.f) sort_up(axis, max_index);
+        if (min_delta > 0.f) sort_up(axis, _proxies[proxy].min_index[axis]);
+        if (max_delta < 0.f) sort_down(axis, _proxies[proxy].max_index[axis]);
+    }
+}
+
+auto sweep_broadphase::update_pairs(std::vector<body_pair>& pairs) -> void {
+    if (_dead_endpoints) remove_dead_endpoints();
+    if (!_pending_proxies.empty()) insert_pending();
+
+    // Each pair is listed by both proxies; the lower one reports it
+    for (auto proxy = proxy_id{0}; proxy < _partners.size(); ++proxy) {
+        for (auto const other : _partners[proxy]) {
+            if (other < proxy) continue;
+
+            auto const entity_a = _proxies[proxy].entity;
+            auto const entity_b = _proxies[other].entity;
+            pairs.push_back({std::min(entity_a, entity_b), std::max(entity_a, entity_b)});
+        }
+    }
+}
+
+// Endpoint lists answer "what overlaps this box" poorly: every proxy starting left of the box has to be
+// visited in case it spans it. Good enough for occasional queries.
+auto sweep_broadphase::query(aabb const& bounds, std::vector<entity_id>& entities) -> void {
+    if (!_pending_proxies.empty()) insert_pending();
+
+    for (auto const& current : _endpoints[0]) {
+        if (current.value > bounds.max.x) break;
+        if (current.is_max || current.proxy == DEAD_PROXY) continue;
+
+        auto const& proxy = _proxies[current.proxy];
+        if (overlaps(proxy.bounds, bounds)) entities.push_back(proxy.entity);
+    }
+}
+
+auto sweep_broadphase::query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void {
+    if (!_pending_proxies.empty()) insert_pending();
+
+    auto const max_x = std::max(from.x, to.x);
+    for (auto const& current : _endpoints[0]) {
+        if (current.value > max_x) break;
+        if (current.is_max || current.proxy == DEAD_PROXY) continue;
+
+        auto const& proxy = _proxies[current.proxy];
+        if (overlaps(proxy.bounds, from, to)) entities.push_back(proxy.entity);
+    }
+}
+
+auto sweep_broadphase::save(snapshot_writer& writer) const -> void {
+    writer.write(_endpoints[0]);
+    writer.write(_endpoints[1]);
+    writer.write(_proxies);
+    writer.write(_free_proxies);
+    writer.write(_pending_proxies);
+    writer.write(_dead_endpoints);
+
+    // Partner order decides pair order, so it is kept as is
+    for (auto const& partners : _partners) writer.write(partners);
+}
+
+auto sweep_broadphase::restore(snapshot_reader& reader) -> void {
+    reader.read(_endpoints[0]);
+    reader.read(_endpoints[1]);
+    reader.read(_proxies);
+    reader.read(_free_proxies);
+    reader.read(_pending_proxies);
+    reader.read(_dead_endpoints);
+
+    _partners.resize(_proxies.size());
+    for (auto& partners : _partners) reader.read(partners);
+}
+
+auto sweep_broadphase::remove_dead_endpoints() -> void {
+    for (auto axis = std::size_t{0}; axis < 2; ++axis) {
+        auto& endpoints = _endpoints[axis];
+        std::erase_if(endpoints, [](auto const& current) { return current.proxy == DEAD_PROXY; });
+
+        for (auto i = std::uint32_t{0}; i < endpoints.size(); ++i) {
+            auto& current = _proxies[endpoints[i].proxy];
+            (endpoints[i].is_max ? current.max_index : current.min_index)[axis] = i;
+        }
+    }
+
+    _dead_endpoints = 0;
+}
+
+auto sweep_broadphase::insert_pending() -> void {
+    if (_dead_endpoints) remove_dead_endpoints();
+
+    // A destroyed and re-created proxy can be listed twice; the pending flag keeps only one
+    std::erase_if(_pending_proxies, [this](proxy_id const proxy) {
+        if (!_proxies[proxy].pending) return true;
+        _proxies[proxy].pending = false;
+        return false;
+    });
+
+    for (auto axis = std::size_t{0}; axis < 2; ++axis) {
+        auto& endpoints = _endpoints[axis];
+        auto const existing = endpoints.size();
+
+        for (auto const proxy : _pending_proxies) {
+            endpoints.push_back({value_of(_proxies[proxy].bounds, axis, false), proxy, false});
+            endpoints.push_back({value_of(_proxies[proxy].bounds, axis, true), proxy, true});
+        }
+
+        // Ties keep existing endpoints first, which is where insertion sort would have stopped
+        auto const by_value = [](auto const& a, auto const& b) { return a.value < b.value; };
+        std::stable_sort(endpoints.begin() + static_cast<std::ptrdiff_t>(existing), endpoints.end(), by_value);
+
+        _merge_buffer.resize(endpoints.size());
+        std::merge(endpoints.begin(), endpoints.begin() + static_cast<std::ptrdiff_t>(existing),
+                   endpoints.begin() + static_cast<std::ptrdiff_t>(existing), endpoints.end(),
+                   _merge_buffer.begin(), by_value);
+        endpoints.swap(_merge_buffer);
+
+        for (auto i = std::uint32_t{0}; i < endpoints.size(); ++i) {
+            auto& current = _proxies[endpoints[i].proxy];
+            (endpoints[i].is_max ? current.max_index : current.min_index)[axis] = i;
+        }
+    }
+
+    for (auto const proxy : _pending_proxies) _proxies[proxy].pending = true;
+
+    // One sweep along x finds every pair involving a new proxy; old proxies only need testing against new ones
+    _active_old.clear();
+    _active_new.clear();
+
+    for (auto const& current : _endpoints[0]) {
+        auto const is_new = _proxies[current.proxy].pending;
+        auto& active = is_new ? _active_new : _active_old;
+
+        if (current.is_max) {
+            active.erase(std::find(active.begin(), active.end(), current.proxy));
+            continue;
+        }
+
+        for (auto const other : _active_new)
+            if (overlaps_on(1, current.proxy, other)) add_pair(current.proxy, other);
+
+        if (is_new)
+            for (auto const other : _active_old)
+                if (overlaps_on(1, current.proxy, other)) add_pair(current.proxy, other);
+
+        active.push_back(current.proxy);
+    }
+
+    for (auto const proxy : _pending_proxies) _proxies[proxy].pending = false;
+    _pending_proxies.clear();
+}
+
+auto sweep_broadphase::sort_down(std::size_t const axis, std::uint32_t index) -> void {
+    auto const& endpoints = _endpoints[axis];
+
+    while (index > 0 && endpoints[index - 1].value > endpoints[index].value) {
+        swap_endpoints(axis, index - 1);
+        --index;
+    }
+}
+
+auto sweep_broadphase::sort_up(std::size_t const axis, std::uint32_t index) -> void {
+    auto const& endpoints = _endpoints[axis];
+
+    while (index + 1 < endpoints.size() && endpoints[index + 1].value < endpoints[index].value) {
+        swap_endpoints(axis, index);
+        ++index;
+    }
+}
+
+auto sweep_broadphase::swap_endpoints(std::size_t const axis, std::uint32_t const lower) -> void {
+    auto& endpoints = _endpoints[axis];
+    std::swap(endpoints[lower], endpoints[lower + 1]);
+
+    auto const& first = endpoints[lower];
+    auto const& second = endpoints[lower + 1];
+
+    // A destroyed proxy's endpoint only has to get out of the way
+    if (first.proxy == DEAD_PROXY || second.proxy == DEAD_PROXY) {
+        if (first.proxy != DEAD_PROXY) (first.is_max ? _proxies[first.proxy].max_index : _proxies[first.proxy].min_index)[axis] = lower;
+        if (second.proxy != DEAD_PROXY) (second.is_max ? _proxies[second.proxy].max_index : _proxies[second.proxy].min_index)[axis] = lower + 1;
+        return;
+    }
+
+    (first.is_max ? _proxies[first.proxy].max_index : _proxies[first.proxy].min_index)[axis] = lower;
+    (second.is_max ? _proxies[second.proxy].max_index : _proxies[second.proxy].min_index)[axis] = lower + 1;
+
+    // A max now ahead of a min means the two separated on this axis; a min ahead of a max means they
+    // overlap on this axis and begin touching if they also overlap on the other one
+    if (first.is_max && !second.is_max) {
+        remove_pair(first.proxy, second.proxy);
+    } else if (!first.is_max && second.is_max) {
+        if (overlaps_on(1 - axis, first.proxy, second.proxy)) add_pair(first.proxy, second.proxy);
+    }
+}
+
+// Tested on endpoint order rather than values so pairs stay consistent with the lists when values tie
+auto sweep_broadphase::overlaps_on(std::size_t const axis, proxy_id const a, proxy_id const b) const -> bool {
+    auto const& proxy_a = _proxies[a];
+    auto const& proxy_b = _proxies[b];
+
+    return proxy_a.min_index[axis] < proxy_b.max_index[axis] && proxy_b.min_index[axis] < proxy_a.max_index[axis];
+}
+
+// Partner lists are a handful long, so searching them beats hashing and never allocates once warm
+auto sweep_broadphase::add_pair(proxy_id const a, proxy_id const b) -> void {
+    auto& partners_a = _partners[a];
+    if (std::find(partners_a.begin(), partners_a.end(), b) != partners_a.end()) return;
+
+    partners_a.push_back(b);
+    _partners[b].push_back(a);
+}
+
+auto sweep_broadphase::remove_pair(proxy_id const a, proxy_id const b) -> void {
+    auto const remove = [](std::vector<proxy_id>& partners, proxy_id const other) {
+        auto const found = std::find(partners.begin(), partners.end(), other);
+        if (found == partners.end()) return false;
+
+        *found = partners.back();
+        partners.pop_back();
+        return true;
+    };
+
+    if (remove(_partners[a], b)) remove(_partners[b], a);
+}
+
+}
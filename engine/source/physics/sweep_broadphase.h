@@ -0,0 +1,75 @@
+#ifndef ENGINE_PHYSICS_SWEEP_BROADPHASE_H
+#define ENGINE_PHYSICS_SWEEP_BROADPHASE_H
+
+#include <physics/broadphase.h>
+
+namespace xc {
+
+// Sweep and prune over persistent endpoint lists on both axes. Moves are applied with insertion
+// sort, so the cost follows how far bodies travel rather than how many there are, and pairs begin
+// and end exactly when endpoints swap. Each proxy keeps its own list of partners, so the pair set
+// costs nothing to maintain between swaps. New proxies are merged in as a batch on the next update,
+// which keeps spawning a whole level from costing a quadratic number of swaps; destroyed ones leave
+// dead endpoints behind that the same update compacts away in one pass.
+class sweep_broadphase final : public broadphase {
+    friend class broadphase;
+
+public:
+    auto create_proxy(aabb const& bounds, entity_id entity) -> proxy_id final;
+    auto destroy_proxy(proxy_id proxy) -> void final;
+    auto move_proxy(proxy_id proxy, aabb const& bounds, vector2 const& displacement) -> void final;
+
+    auto update_pairs(std::vector<body_pair>& pairs) -> void final;
+    auto query(aabb const& bounds, std::vector<entity_id>& entities) -> void final;
+    auto query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void final;
+
+    auto save(snapshot_writer& writer) const -> void final;
+    auto restore(snapshot_reader& reader) -> void final;
+
+private:
+    sweep_broadphase();
+
+    struct endpoint {
+        float value;
+        proxy_id proxy;
+        bool is_max;
+    };
+
+    struct proxy {
+        aabb bounds;
+        entity_id entity;
+        std::array<std::uint32_t, 2> min_index, max_index;
+        bool in_use, pending;
+    };
+
+    // Endpoints of destroyed proxies until the next compaction
+    auto static constexpr DEAD_PROXY = ~proxy_id{0};
+    auto static constexpr INITIAL_PARTNERS = std::size_t{8};
+
+    auto static value_of(aabb const& bounds, std::size_t axis, bool is_max) -> float;
+
+    auto remove_dead_endpoints() -> void;
+    auto insert_pending() -> void;
+
+    auto sort_down(std::size_t axis, std::uint32_t index) -> void;
+    auto sort_up(std::size_t axis, std::uint32_t index) -> void;
+    auto swap_endpoints(std::size_t axis, std::uint32_t lower) -> void;
+
+    auto overlaps_on(std::size_t axis, proxy_id a, proxy_id b) const -> bool;
+
+    auto add_pair(proxy_id a, proxy_id b) -> void;
+    auto remove_pair(proxy_id a, proxy_id b) -> void;
+
+    std::array<std::vector<endpoint>, 2> _endpoints;
+
+    std::vector<proxy> _proxies;
+    std::vector<std::vector<proxy_id>> _partners; // indexed by proxy, each pair listed on both sides
+    std::vector<proxy_id> _free_proxies, _pending_proxies;
+    std::vector<endpoint> _merge_buffer;
+    std::vector<proxy_id> _active_old, _active_new;
+    std::size_t _dead_endpoints = 0; // per axis
+};
+
+}
+
+#endif // ENGINE_PHYSICS_SWEEP_BROADPHASE_H
@@ -0,0 +1,77 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "tile_colliders.h"
+
+#include <physics/physics.h>
+
+#include <ldtk.hpp>
+
+namespace xc {
+
+auto merge_tiles(std::span<std::int64_t const> cells, std::uint32_t const columns, std::uint32_t const rows,
+                 float const tile_size, vector2 const& origin, std::vector<aabb>& boxes) -> void {
+    if (cells.size() < static_cast<std::size_t>(columns) * rows) return;
+
+    // Cells already covered by a box in this chunk
+    auto merged = std::vector<bool>(TILE_CHUNK_SIZE * TILE_CHUNK_SIZE);
+
+    for (auto chunk_y = std::uint32_t{0}; chunk_y < rows; chunk_y += TILE_CHUNK_SIZE) {
+        for (auto chunk_x = std::uint32_t{0}; chunk_x < columns; chunk_x += TILE_CHUNK_SIZE) {
+            auto const end_x = std::min(chunk_x + TILE_CHUNK_SIZE, columns);
+            auto const end_y = std::min(chunk_y + TILE_CHUNK_SIZE, rows);
+
+            auto const is_open = [&](std::uint32_t const x, std::uint32_t const y) {
+                return cells[static_cast<std::size_t>(y) * columns + x] != 0 && !merged[(y - chunk_y) * TILE_CHUNK_SIZE + (x - chunk_x)];
+            };
+
+            std::fill(merged.begin(), merged.end(), false);
+
+            for (auto y = chunk_y; y < end_y; ++y) {
+                for (auto x = chunk_x; x < end_x; ++x) {
+                    if (!is_open(x, y)) continue;
+
+                    auto right = x + 1;
+                    while (right < end_x && is_open(right, y)) ++right;
+
+                    auto bottom = y + 1;
+                    while (bottom < end_y) {
+                        auto row_open = true;
+                        for (auto column = x; column < right && row_open; ++column) row_open = is_open(column, bottom);
+                        if (!row_open) break;
+                        ++bottom;
+                    }
+
+                    for (auto row = y; row < bottom; ++row)
+                        for (auto column = x; column < right; ++column)
+                            merged[(row - chunk_y) * TILE_CHUNK_SIZE + (column - chunk_x)] = true;
+
+                    boxes.push_back({
+                        origin + vector2{static_cast<float>(x), static_cast<float>(y)} * tile_size,
+                        origin + vector2{static_cast<float>(right), static_cast<float>(bottom)} * tile_size});
+                }
+            }
+        }
+    }
+}
+
+auto add_ldtk_colliders(physics& physics, quicktype::level const& level, std::string_view const layer,
+                        std::uint32_t const category) -> std::size_t {
+    if (!level.layer_instances) return 0;
+
+    auto added = std::size_t{0};
+    for (auto const& instance : *level.layer_instances) {
+        if (instance.type != "IntGrid" || (!layer.empty() && instance.identifier != layer)) continue;
+
+        auto const origin = vector2{static_cast<float>(level.world_x + instance.px_total_offset_x),
+                                    static_cast<float>(level.world_y + instance.px_total_offset_y)};
+
+        physics.add_tile_layer(instance.int_grid_csv, static_cast<std::uint32_t>(instance.c_wid), static_cast<std::uint32_t>(instance.c_hei),
+                               static_cast<float>(instance.grid_size), origin, category);
+        ++added;
+    }
+
+    return added;
+}
+
+}
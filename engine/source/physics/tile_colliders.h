@@ -0,0 +1,31 @@
+#ifndef ENGINE_PHYSICS_TILE_COLLIDERS_H
+#define ENGINE_PHYSICS_TILE_COLLIDERS_H
+
+#include <physics/types.h>
+
+#include <span>
+#include <string_view>
+
+namespace quicktype { struct level; }
+
+namespace xc {
+
+class physics;
+
+// Tiles are merged within square chunks of this many tiles, so no box spans a chunk boundary
+auto static constexpr TILE_CHUNK_SIZE = std::uint32_t{16};
+
+// Greedily merges the solid (non-zero) cells of a row-major grid into as few boxes as it can, a chunk at
+// a time: each box grows right along its row, then down while every cell beneath it is solid. Boxes are
+// appended in world units with the grid's top-left corner at `origin`.
+auto merge_tiles(std::span<std::int64_t const> cells, std::uint32_t columns, std::uint32_t rows,
+                 float tile_size, vector2 const& origin, std::vector<aabb>& boxes) -> void;
+
+// Adds every IntGrid layer of an LDtk level, or only the one called `layer` if given, as static tile
+// colliders. Returns how many layers were added.
+auto add_ldtk_colliders(physics& physics, quicktype::level const& level, std::string_view layer = {},
+                        std::uint32_t category = 1) -> std::size_t;
+
+}
+
+#endif // ENGINE_PHYSICS_TILE_COLLIDERS_H
@@ -0,0 +1,338 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+#include "tree_broadphase.h"
+
+#include <algorithm>
+
+namespace xc {
+
+auto static constexpr FAT_MARGIN = 4.f;
+auto static constexpr DISPLACEMENT_MULTIPLIER = 4.f;
+
+auto static constexpr merge(aabb const& a, aabb const& b) -> aabb {
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+
+auto static constexpr contains(aabb const& outer, aabb const& inner) -> bool {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y
+        && inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+auto static constexpr perimeter(aabb const& a) -> float {
+    return 2.f * ((a.max.x - a.min.x) + (a.max.y - a.min.y));
+}
+
+auto static fatten(aabb const& bounds, vector2 const& displacement) -> aabb {
+    auto fat = aabb{bounds.min - FAT_MARGIN, bounds.max + FAT_MARGIN};
+    auto const predicted = displacement * DISPLACEMENT_MULTIPLIER;
+
+    if (predicted.x < 0.f) fat.min.x += predicted.x; else fat.max.x += predicted.x;
+    if (predicted.y < 0.f) fat.min.y += predicted.y; else fat.max.y += predicted.y;
+
+    return fat;
+}
+
+tree_broadphase::tree_broadphase(bool const track_moves) : _track_moves{track_moves} {}
+
+auto tree_broadphase::create_proxy(aabb const& bounds, entity_id const entity) -> proxy_id {
+    auto const leaf = allocate_node();
+
+    _nodes[leaf].bounds = fatten(bounds, {0.f, 0.f});
+    _nodes[leaf].entity = entity;
+    _nodes[leaf].height = 0;
+    _nodes[leaf].moved = _track_moves;
+
+    insert_leaf(leaf);
+    if (_track_moves) _move_buffer.push_back(static_cast<proxy_id>(leaf));
+
+    return static_cast<proxy_id>(leaf);
+}
+
+auto tree_broadphase::destroy_proxy(proxy_id const proxy) -> void {
+    auto const leaf = static_cast<std::int32_t>(proxy);
+    if (_nodes[leaf].moved) std::erase(_move_buffer, proxy);
+
+    remove_leaf(leaf);
+    free_node(leaf);
+}
+
+auto tree_broadphase::move_proxy(proxy_id const proxy, aabb const& bounds, vector2 const& displacement) -> void {
+    auto const leaf = static_cast<std::int32_t>(proxy);
+    if (contains(_nodes[leaf].bounds, bounds)) return;
+
+    remove_leaf(leaf);
+    _nodes[leaf].bounds = fatten(bounds, displacement);
+    insert_leaf(leaf);
+
+    if (_track_moves && !_nodes[leaf].moved) {
+        _nodes[leaf].moved = true;
+        _move_buffer.push_back(proxy);
+    }
+}
+
+auto tree_broadphase::update_pairs(std::vector<body_pair>& pairs) -> void {
+    // Drop pairs whose fat bounds separated or whose proxies were destroyed
+    std::erase_if(_pairs, [this](auto const& pair) {
+        auto const& node_a = _nodes[pair.a];
+        auto const& node_b = _nodes[pair.b];
+        return node_a.height != 0 || node_b.height != 0 || !overlaps(node_a.bounds, node_b.bounds);
+    });
+
+    // Only proxies that were re-inserted can have gained new partners
+    _new_pairs.clear();
+    for (auto const proxy : _move_buffer) {
+        auto const& moved_node = _nodes[proxy];
+        if (moved_node.height != 0) continue;
+
+        traverse([&](aabb const& bounds) { return overlaps(bounds, moved_node.bounds); }, [&](std::int32_t const other) {
+            if (static_cast<proxy_id>(other) == proxy) return;
+
+            // Both moved: the pair is found from either side, keep the one from the lower id
+            if (_nodes[other].moved && static_cast<proxy_id>(other) < proxy) return;
+
+            _new_pairs.push_back({std::min(proxy, static_cast<proxy_id>(other)),
+                                  std::max(proxy, static_cast<proxy_id>(other))});
+        });
+    }
+
+    for (auto const proxy : _move_buffer) _nodes[proxy].moved = false;
+    _move_buffer.clear();
+
+    auto constexpr pair_less = [](auto const& a, auto const& b) { return a.a < b.a || (a.a == b.a && a.b < b.b); };
+    auto constexpr pair_equal = [](auto const& a, auto const& b) { return a.a == b.a && a.b == b.b; };
+
+    std::sort(_new_pairs.begin(), _new_pairs.end(), pair_less);
+
+    auto const existing = _pairs.size();
+    _pairs.insert(_pairs.end(), _new_pairs.begin(), _new_pairs.end());
+    std::inplace_merge(_pairs.begin(), _pairs.begin() + static_cast<std::ptrdiff_t>(existing), _pairs.end(), pair_less);
+    _pairs.erase(std::unique(_pairs.begin(), _pairs.end(), pair_equal), _pairs.end());
+
+    for (auto const& pair : _pairs) {
+        auto const entity_a = _nodes[pair.a].entity;
+        auto const entity_b = _nodes[pair.b].entity;
+        pairs.push_back({std::min(entity_a, entity_b), std::max(entity_a, entity_b)});
+    }
+}
+
+auto tree_broadphase::query(aabb const& bounds, std::vector<entity_id>& entities) -> void {
+    traverse([&](aabb const& node_bounds) { return overlaps(node_bounds, bounds); },
+             [&](std::int32_t const leaf) { entities.push_back(_nodes[leaf].entity); });
+}
+
+auto tree_broadphase::query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void {
+    traverse([&](aabb const& node_bounds) { return overlaps(node_bounds, from, to); },
+             [&](std::int32_t const leaf) { entities.push_back(_nodes[leaf].entity); });
+}
+
+auto tree_broadphase::save(snapshot_writer& writer) const -> void {
+    writer.write(_root);
+    writer.write(_free_list);
+    writer.write(_nodes);
+    writer.write(_move_buffer);
+    writer.write(_pairs);
+}
+
+auto tree_broadphase::restore(snapshot_reader& reader) -> void {
+    reader.read(_root);
+    reader.read(_free_list);
+    reader.read(_nodes);
+    reader.read(_move_buffer);
+    reader.read(_pairs);
+}
+
+auto tree_broadphase::allocate_node() -> std::int32_t {
+    if (_free_list == -1) {
+        _nodes.push_back(node{});
+        _nodes.back().height = -1;
+        _free_list = static_cast<std::int32_t>(_nodes.size() - 1);
+        _nodes.back().parent = -1;
+    }
+
+    auto const index = _free_list;
+    _free_list = _nodes[index].parent;
+
+    _nodes[index].parent = -1;
+    _nodes[index].child_a = -1;
+    _nodes[index].child_b = -1;
+    _nodes[index].height = 0;
+    _nodes[index].moved = false;
+
+    return index;
+}
+
+auto tree_broadphase::free_node(std::int32_t const index) -> void {
+    _nodes[index].parent = _free_list;
+    _nodes[index].height = -1;
+    _free_list = index;
+}
+
+auto tree_broadphase::insert_leaf(std::int32_t const leaf) -> void {
+    if (_root == -1) {
+        _root = leaf;
+        _nodes[leaf].parent = -1;
+        return;
+    }
+
+    // Descend towards the sibling with the lowest perimeter cost
+    auto const leaf_bounds = _nodes[leaf].bounds;
+    auto index = _root;
+
+    while (_nodes[index].height > 0) {
+        auto const child_a = _nodes[index].child_a;
+        auto const child_b = _nodes[index].child_b;
+
+        auto const area = perimeter(_nodes[index].bounds);
+        auto const combined_area = perimeter(merge(_nodes[index].bounds, leaf_bounds));
+
+        // Cost of creating a new parent here, and the minimum cost pushed down to the children
+        auto const cost = 2.f * combined_area;
+        auto const inheritance_cost = 2.f * (combined_area - area);
+
+        auto const child_cost = [&](std::int32_t const child) {
+            auto const merged = perimeter(merge(leaf_bounds, _nodes[child].bounds));
+            return _nodes[child].height == 0
+                ? merged + inheritance_cost
+                : merged - perimeter(_nodes[child].bounds) + inheritance_cost;
+        };
+
+        auto const cost_a = child_cost(child_a);
+        auto const cost_b = child_cost(child_b);
+
+        if (cost < cost_a && cost < cost_b) break;
+
+        index = cost_a < cost_b ? child_a : child_b;
+    }
+
+    auto const sibling = index;
+    auto const old_parent = _nodes[sibling].parent;
+    auto const new_parent = allocate_node();
+
+    _nodes[new_parent].parent = old_parent;
+    _nodes[new_parent].bounds = merge(leaf_bounds, _nodes[sibling].bounds);
+    _nodes[new_parent].height = _nodes[sibling].height + 1;
+    _nodes[new_parent].child_a = sibling;
+    _nodes[new_parent].child_b = leaf;
+    _nodes[sibling].parent = new_parent;
+    _nodes[leaf].parent = new_parent;
+
+    if (old_parent == -1) _root = new_parent;
+    else if (_nodes[old_parent].child_a == sibling) _nodes[old_parent].child_a = new_parent;
+    else _nodes[old_parent].child_b = new_parent;
+
+    // Walk back up refitting bounds and rebalancing
+    for (index = _nodes[leaf].parent; index != -1; index = _nodes[index].parent) {
+        index = balance(index);
+
+        auto const child_a = _nodes[index].child_a;
+        auto const child_b = _nodes[index].child_b;
+
+        _nodes[index].height = 1 + std::max(_nodes[child_a].height, _nodes[child_b].height);
+        _nodes[index].bounds = merge(_nodes[child_a].bounds, _nodes[child_b].bounds);
+    }
+}
+
+auto tree_broadphase::remove_leaf(std::int32_t const leaf) -> void {
+    if (leaf == _root) {
+        _root = -1;
+        return;
+    }
+
+    auto const parent = _nodes[leaf].parent;
+    auto const grand_parent = _nodes[parent].parent;
+    auto const sibling = _nodes[parent].child_a == leaf ? _nodes[parent].child_b : _nodes[parent].child_a;
+
+    free_node(parent);
+
+    if (grand_parent == -1) {
+        _root = sibling;
+        _nodes[sibling].parent = -1;
+        return;
+    }
+
+    if (_nodes[grand_parent].child_a == parent) _nodes[grand_parent].child_a = sibling;
+    else _nodes[grand_parent].child_b = sibling;
+    _nodes[sibling].parent = grand_parent;
+
+    for (auto index = grand_parent; index != -1; index = _nodes[index].parent) {
+        index = balance(index);
+
+        auto const child_a = _nodes[index].child_a;
+        auto const child_b = _nodes[index].child_b;
+
+        _nodes[index].bounds = merge(_nodes[child_a].bounds, _nodes[child_b].bounds);
+        _nodes[index].height = 1 + std::max(_nodes[child_a].height, _nodes[child_b].height);
+    }
+}
+
+// Rotates the taller child of `a` up into its place when the subtree heights differ by more than one.
+// Returns the index of the subtree's new root.
+auto tree_broadphase::balance(std::int32_t const a) -> std::int32_t {
+    auto& node_a = _nodes[a];
+    if (node_a.height < 2) return a;
+
+    auto const b = node_a.child_a;
+    auto const c = node_a.child_b;
+    auto const height_difference = _nodes[c].height - _nodes[b].height;
+
+    if (height_difference >= -1 && height_difference <= 1) return a;
+
+    // Promote the taller child `up`; `down` stays beneath `a`
+    auto const up = height_difference > 1 ? c : b;
+    auto const down = height_difference > 1 ? b : c;
+
+    auto const f = _nodes[up].child_a;
+    auto const g = _nodes[up].child_b;
+
+    // Swap `a` and `up`
+    _nodes[up].child_a = a;
+    _nodes[up].parent = node_a.parent;
+    node_a.parent = up;
+
+    if (_nodes[up].parent == -1) _root = up;
+    else if (_nodes[_nodes[up].parent].child_a == a) _nodes[_nodes[up].parent].child_a = up;
+    else _nodes[_nodes[up].parent].child_b = up;
+
+    // The taller grandchild stays with `up`, the shorter one moves under `a`
+    auto const keep = _nodes[f].height > _nodes[g].height ? f : g;
+    auto const move = keep == f ? g : f;
+
+    _nodes[up].child_b = keep;
+    if (height_difference > 1) node_a.child_b = move; else node_a.child_a = move;
+    _nodes[move].parent = a;
+
+    node_a.bounds = merge(_nodes[down].bounds, _nodes[move].bounds);
+    node_a.height = 1 + std::max(_nodes[down].height, _nodes[move].height);
+
+    _nodes[up].bounds = merge(node_a.bounds, _nodes[keep].bounds);
+    _nodes[up].height = 1 + std::max(node_a.height, _nodes[keep].height);
+
+    return up;
+}
+
+// Visits every leaf whose bounds, and whose ancestors' bounds, pass `test`
+template<class T, class F> auto tree_broadphase::traverse(T&& test, F&& callback) -> void {
+    if (_root == -1) return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+
+    while (!_stack.empty()) {
+        auto const index = _stack.back();
+        _stack.pop_back();
+
+        auto const& current = _nodes[index];
+        if (!test(current.bounds)) continue;
+
+        if (current.height == 0) {
+            callback(index);
+        } else {
+            _stack.push_back(current.child_a);
+            _stack.push_back(current.child_b);
+        }
+    }
+}
+
+}
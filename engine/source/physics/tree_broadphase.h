@@ -0,0 +1,63 @@
+#ifndef ENGINE_PHYSICS_TREE_BROADPHASE_H
+#define ENGINE_PHYSICS_TREE_BROADPHASE_H
+
+#include <physics/broadphase.h>
+
+namespace xc {
+
+// Dynamic AABB tree. Leaves store bounds enlarged by a margin and the predicted displacement, so a
+// proxy is only re-inserted once it leaves its fat bounds. Candidate pairs persist between updates
+// and only proxies that were re-inserted are queried again; a tree that is only queried doesn't track them.
+class tree_broadphase final : public broadphase {
+    friend class broadphase;
+
+public:
+    auto create_proxy(aabb const& bounds, entity_id entity) -> proxy_id final;
+    auto destroy_proxy(proxy_id proxy) -> void final;
+    auto move_proxy(proxy_id proxy, aabb const& bounds, vector2 const& displacement) -> void final;
+
+    auto update_pairs(std::vector<body_pair>& pairs) -> void final;
+    auto query(aabb const& bounds, std::vector<entity_id>& entities) -> void final;
+    auto query(vector2 const& from, vector2 const& to, std::vector<entity_id>& entities) -> void final;
+
+    auto save(snapshot_writer& writer) const -> void final;
+    auto restore(snapshot_reader& reader) -> void final;
+
+private:
+    explicit tree_broadphase(bool track_moves);
+
+    struct node {
+        aabb bounds;
+        entity_id entity;
+        std::int32_t parent, child_a, child_b; // parent doubles as the free list link
+        std::int32_t height;                   // -1 for free nodes, 0 for leaves
+        bool moved;
+    };
+
+    struct proxy_pair {
+        proxy_id a, b;
+    };
+
+    auto allocate_node() -> std::int32_t;
+    auto free_node(std::int32_t index) -> void;
+
+    auto insert_leaf(std::int32_t leaf) -> void;
+    auto remove_leaf(std::int32_t leaf) -> void;
+    auto balance(std::int32_t index) -> std::int32_t;
+
+    template<class T, class F> auto traverse(T&& test, F&& callback) -> void;
+
+    bool _track_moves;
+
+    std::int32_t _root = -1;
+    std::int32_t _free_list = -1;
+
+    std::vector<node> _nodes;
+    std::vector<proxy_id> _move_buffer;
+    std::vector<proxy_pair> _pairs, _new_pairs;
+    std::vector<std::int32_t> _stack;
+};
+
+}
+
+#endif // ENGINE_PHYSICS_TREE_BROADPHASE_H
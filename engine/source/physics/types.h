@@ -2,17 +2,125 @@
 #define ENGINE_PHYSICS_TYPES_H
 
 #include <core/types.h>
+#include <core/fixed.h>
 #include <scene/types.h>
 
-struct collision_component {
-    xc::entity_id collider;
+#include <algorithm>
+
+namespace xc {
+
+// Building with PHYSICS_FIXED_POINT=32 runs the simulation on Q32.32 fixed-point scalars, which makes it
+// bit-identical across builds for lockstep play and replays; otherwise it runs on floats
+#if PHYSICS_FIXED_POINT == 32
+using real = q32_32;
+#elif PHYSICS_FIXED_POINT
+#error "PHYSICS_FIXED_POINT must be 32: fewer integer bits can't hold squared distances across the map"
+#else
+using real = float;
+#endif
+
+using real2 = vector<real, 2>;
+
+auto constexpr to_real2(vector2 const& value) -> real2 { return {real{value.x}, real{value.y}}; }
+auto constexpr to_vector2(real2 const& value) -> vector2 { return {static_cast<float>(value.x), static_cast<float>(value.y)}; }
+
+// Boxes stay axis aligned whatever the body's rotation; capsules and polygons turn with it
+enum class shape_type : std::uint8_t { eCircle, eCapsule, eBox, ePolygon };
+
+auto static constexpr MAX_POLYGON_VERTICES = std::uint32_t{8};
+
+// Convex polygon in body space around the body's position, with outward face normals
+struct convex_polygon {
+    std::array<real2, MAX_POLYGON_VERTICES> vertices, normals;
+    std::uint32_t count;
+    real inner_radius; // of the largest circle about the position that fits inside
 };
 
+}
+
 struct physics_body_component {
-    xc::vector2 position, velocity, force;
-    float angular_velocity, rotation, torque;
-    float inverse_mass, inverse_inertia_tensor, damping;
-    float radius;
+    xc::real2 position, velocity, force;
+    xc::real angular_velocity, rotation, torque;
+    xc::real2 previous_position;  // pose at the start of the last tick, for render interpolation
+    xc::real previous_rotation;
+    xc::real inverse_mass, inverse_inertia_tensor, damping;
+    xc::real radius;              // of the circle, or of the capsule around its segment
+    xc::shape_type shape;
+    xc::real2 extents;            // box half extents; a capsule's half length is extents.x
+    std::uint32_t polygon;        // index of a convex_polygon registered with physics
+    xc::real restitution, friction;
+    std::uint32_t category, mask; // two bodies collide when each one's category is in the other's mask
+    bool is_sensor;               // reports overlaps but never moves and is never pushed
+    bool is_bullet;               // always swept, against dynamic bodies as well as static ones
+};
+
+namespace xc {
+
+struct aabb { vector2 min, max; };
+
+struct body_pair { entity_id a, b; };
+
+enum class contact_phase { eBegin, eStay, eEnd };
+
+struct contact_event {
+    body_pair pair;
+    contact_phase phase;
+};
+
+// Normal points from a to b
+struct contact {
+    body_pair pair;
+    real2 normal, point;
+    real penetration;
 };
 
-#endif // ENGINE_PHYSICS_TYPES_H
\ No newline at end of file
+// Stands in for the tile walls in query results, since they have no entity of their own
+auto static constexpr TILE_ENTITY = ~entity_id{0};
+
+struct raycast_hit {
+    entity_id entity;   // TILE_ENTITY for a wall
+    vector2 point, normal;
+    float fraction; // along the ray, 0 at its start and 1 at its end
+};
+
+// A body's pose blended between the last two ticks
+struct pose {
+    vector2 position;
+    float rotation;
+};
+
+// What the last tick spent its time on, in milliseconds, and how much work there was
+struct physics_stats {
+    double sync_ms, integrate_forces_ms, broadphase_ms, narrowphase_ms, solver_ms, integrate_velocities_ms, sleep_ms;
+    std::uint32_t candidate_pairs, contacts, awake_bodies, sleeping_bodies;
+};
+
+using proxy_id = std::uint32_t;
+auto static constexpr null_proxy = ~proxy_id{0};
+
+auto constexpr overlaps(aabb const& a, aabb const& b) -> bool {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+// Slab test for the segment from `from` to `to`
+auto constexpr overlaps(aabb const& bounds, vector2 const& from, vector2 const& to) -> bool {
+    auto enter = 0.f, exit = 1.f;
+
+    auto const clip = [&](float const start, float const delta, float const min, float const max) {
+        if (delta == 0.f) return start >= min && start <= max;
+
+        auto near = (min - start) / delta;
+        auto far = (max - start) / delta;
+        if (near > far) std::swap(near, far);
+
+        enter = std::max(enter, near);
+        exit = std::min(exit, far);
+        return enter <= exit;
+    };
+
+    return clip(from.x, to.x - from.x, bounds.min.x, bounds.max.x) && clip(from.y, to.y - from.y, bounds.min.y, bounds.max.y);
+}
+
+}
+
+#endif // ENGINE_PHYSICS_TYPES_H
@@ -24,7 +24,11 @@ sdl2_platform::~sdl2_platform() {
 
 auto sdl2_platform::create_window(int width, int height) -> void {
     auto constexpr position = SDL_WINDOWPOS_CENTERED;
+#ifdef RENDERER_VULKAN
+    auto constexpr flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_VULKAN;
+#else
     auto constexpr flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_OPENGL;
+#endif
 
     sdl_window = SDL_CreateWindow("Hello SDL", position, position, width, height, flags);
     if (!sdl_window) throw std::runtime_error(SDL_GetError());
@@ -3,46 +3,104 @@
 #include <platform/sdl2/sdl2_platform.h>
 #ifdef __EMSCRIPTEN__
 #endif // __EMSCRIPTEN__
+#include <stb_image.h>
 #include <SDL.h>
 #include <glad.h>
 
+#include <cstddef>
+
 namespace xc {
 
-auto static constexpr vertices = std::array{
-        -0.5f, -0.5f, 0.0f,
-         0.5f, -0.5f, 0.0f,
-         0.0f,  0.5f, 0.0f
+// Unit quad as a triangle strip; every sprite is one instance of it
+auto static constexpr quad_vertices = std::array{
+        0.f, 0.f,
+        1.f, 0.f,
+        0.f, 1.f,
+        1.f, 1.f
 };
 
+// OpenGL 3.3 on the desktop and WebGL 2 in the browser, whose shaders differ only in this first line
+#ifdef __EMSCRIPTEN__
+auto static constexpr shader_version = "#version 300 es\nprecision mediump float;\n";
+#else
+auto static constexpr shader_version = "#version 330 core\n";
+#endif
+
 auto static constexpr vertex_shader_source = R"(
-    #version 330 core
-    layout (location = 0) in vec3 aPos;
+    layout (location = 0) in vec2 corner;
+    layout (location = 1) in vec4 rect;
+    layout (location = 2) in float rotation;
+    layout (location = 3) in vec4 tint;
+
+    uniform vec2 camera;
+    uniform vec2 logical_size;
+
+    out vec2 uv;
+    out vec4 color;
 
     void main() {
-        gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);
+        // Turn about the centre of the rectangle, clockwise on screen as in the SDL renderer
+        float angle = radians(rotation);
+        vec2 offset = (corner - 0.5) * rect.zw;
+        vec2 turned = vec2(offset.x * cos(angle) - offset.y * sin(angle), offset.x * sin(angle) + offset.y * cos(angle));
+        vec2 position = (rect.xy + rect.zw * 0.5 + turned - camera) / logical_size * 2.0 - 1.0;
+
+        gl_Position = vec4(position.x, -position.y, 0.0, 1.0);
+        uv = corner;
+        color = tint;
     }
 )";
 
 auto static constexpr fragment_shader_source = R"(
-    #version 330 core
+    in vec2 uv;
+    in vec4 color;
+
+    uniform sampler2D sprite;
+
     out vec4 FragColor;
 
     void main() {
-        FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);
+        FragColor = texture(sprite, uv) * color;
     }
 )";
 
-std::uint32_t vertex_shader_id, fragment_shader_id, shader_program_id;
-std::uint32_t vbo_id, vao_id;
-
 SDL_GLContext gl_context;
 
-gl_renderer::gl_renderer(int logical_width, int logical_height) {
+auto static compile_shader(GLenum const type, char const* source) -> std::uint32_t {
+    auto const shader = glCreateShader(type);
+    auto const sources = std::array{shader_version, source};
+    glShaderSource(shader, static_cast<GLsizei>(sources.size()), sources.data(), nullptr);
+    glCompileShader(shader);
+
+    auto result = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+    if (!result) {
+        auto log_length = 0;
+        auto info_log = std::string{};
+
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_length);
+        info_log.resize(log_length);
+        glGetShaderInfoLog(shader, log_length, nullptr, info_log.data());
+
+        log_error("%s", info_log.c_str());
+    }
+
+    return shader;
+}
+
+gl_renderer::gl_renderer(int logical_width, int logical_height)
+    : _logical_size{static_cast<float>(logical_width), static_cast<float>(logical_height)}, _camera{0.f, 0.f} {
     SDL_GL_LoadLibrary(nullptr);
 
+#ifdef __EMSCRIPTEN__
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#else
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+#endif
 
     gl_context = SDL_GL_CreateContext(reinterpret_cast<SDL_Window*>(sdl2_platform::window_handle()));
     if (!gl_context) throw std::runtime_error(SDL_GetError());
@@ -53,103 +111,105 @@ gl_renderer::gl_renderer(int logical_width, int logical_height) {
 
     resize(logical_width, logical_height);
 
-    // init
-    vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader_id, 1, &vertex_shader_source, nullptr);
-    glCompileShader(vertex_shader_id);
+    auto const vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
+    auto const fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+
+    _program = glCreateProgram();
+    glAttachShader(_program, vertex_shader);
+    glAttachShader(_program, fragment_shader);
+    glLinkProgram(_program);
 
     auto result = 0;
-    glad_glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
+    glGetProgramiv(_program, GL_LINK_STATUS, &result);
     if (!result) {
         auto log_length = 0;
         auto info_log = std::string{};
 
-        glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &log_length);
+        glGetProgramiv(_program, GL_INFO_LOG_LENGTH, &log_length);
         info_log.resize(log_length);
-        glGetShaderInfoLog(vertex_shader_id, log_length, nullptr, info_log.data());
+        glGetProgramInfoLog(_program, log_length, nullptr, info_log.data());
 
         log_error("%s", info_log.c_str());
     }
 
-    fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader_id, 1, &fragment_shader_source, nullptr);
-    glCompileShader(fragment_shader_id);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
 
-    glad_glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-    if (!result) {
-        auto log_length = 0;
-        auto info_log = std::string{};
-
-        glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &log_length);
-        info_log.resize(log_length);
-        glGetShaderInfoLog(fragment_shader_id, log_length, nullptr, info_log.data());
-
-        log_error("%s", info_log.c_str());
-    }
+    glUseProgram(_program);
+    glUniform1i(glGetUniformLocation(_program, "sprite"), 0);
+    _camera_location = glGetUniformLocation(_program, "camera");
+    _logical_size_location = glGetUniformLocation(_program, "logical_size");
 
-    shader_program_id = glCreateProgram();
-    glAttachShader(shader_program_id, vertex_shader_id);
-    glAttachShader(shader_program_id, fragment_shader_id);
-    glLinkProgram(shader_program_id);
+    glGenVertexArrays(1, &_vertex_array);
+    glGenBuffers(1, &_quad_buffer);
+    glGenBuffers(1, &_instance_buffer);
 
-    glGetProgramiv(shader_program_id, GL_LINK_STATUS, &result);
-    if (!result) {
-        auto log_length = 0;
-        auto info_log = std::string{};
+    glBindVertexArray(_vertex_array);
 
-        glGetProgramiv(shader_program_id, GL_INFO_LOG_LENGTH, &log_length);
-        info_log.resize(log_length);
-        glGetProgramInfoLog(shader_program_id, log_length, nullptr, info_log.data());
+    glBindBuffer(GL_ARRAY_BUFFER, _quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
 
-        log_error("%s", info_log.c_str());
+    // Instance attributes advance once per sprite; their offsets are set per batch in flush()
+    glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer);
+    for (auto attribute = 1u; attribute <= 3u; ++attribute) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
     }
 
-    glDeleteShader(vertex_shader_id);
-    glDeleteShader(fragment_shader_id);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
 
-    glGenVertexArrays(1, &vao_id);
-    glGenBuffers(1, &vbo_id);
+gl_renderer::~gl_renderer() {
+    for (auto const& texture : _textures) glDeleteTextures(1, &texture.id);
 
-    // Bind the vertex array object
-    glBindVertexArray(vao_id);
+    glDeleteVertexArrays(1, &_vertex_array);
+    glDeleteBuffers(1, &_quad_buffer);
+    glDeleteBuffers(1, &_instance_buffer);
+    glDeleteProgram(_program);
 
-    // Copy vertex array into an OpenGL buffer
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
+    SDL_GL_DeleteContext(gl_context);
+}
 
-    // Set the vertex attrib pointers
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0);
+auto gl_renderer::create_texture(char const* path) -> resource_handle {
+    auto width = 0, height = 0, source_format = 0;
 
-    // the call to vertex_attrib_pointer registered the vbo
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    auto* image = stbi_load(path, &width, &height, &source_format, STBI_rgb_alpha);
+    if (!image) throw std::runtime_error(stbi_failure_reason());
 
-    // Rarely necessary ot unbind the VAO
-    glBindVertexArray(0);
-}
+    auto id = 0u;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
 
-gl_renderer::~gl_renderer() {
-    // cleanup
-    glDeleteVertexArrays(1, &vao_id);
-    glDeleteBuffers(1, &vbo_id);
-    glDeleteProgram(shader_program_id);
+    // Pixel art: no filtering, no bleeding in from the opposite edge
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    SDL_GL_DeleteContext(gl_context);
-}
+    stbi_image_free(image);
 
-auto gl_renderer::create_texture(char const* path) -> resource_handle {
-    return 0u;
+    _textures.push_back({id, width, height});
+    return static_cast<resource_handle>(_textures.size() - 1);
 }
 
 auto gl_renderer::texture_size(resource_handle texture) -> vector2 {
-    return vector2{};
+    auto const& entry = _textures.at(texture);
+    return vector2{static_cast<float>(entry.width), static_cast<float>(entry.height)};
 }
 
 auto gl_renderer::set_camera(xc::vector2 const& camera) -> void {
-
+    // Sprites already queued were placed for the old camera
+    flush();
+    _camera = camera;
 }
 
 auto gl_renderer::clear_screen(color const& clear_color) -> void {
+    flush();
+
     glClearColor(remap(clear_color.r, 0, 255, 0.f, 1.f),
                  remap(clear_color.g, 0, 255, 0.f, 1.f),
                  remap(clear_color.b, 0, 255, 0.f, 1.f),
@@ -160,28 +220,66 @@ auto gl_renderer::clear_screen(color const& clear_color) -> void {
 
 auto gl_renderer::draw_texture(resource_handle          texture,
                                rectangle         const& rect) -> void {
-
+    draw_texture(texture, rect, 0.f, colors::WHITE);
 }
 
 auto gl_renderer::draw_texture(resource_handle          texture,
                                rectangle         const& rect,
                                float                    rotation) -> void {
-
+    draw_texture(texture, rect, rotation, colors::WHITE);
 }
 
 auto gl_renderer::draw_texture(resource_handle          texture,
                                rectangle         const& rect,
                                float                    rotation,
                                color             const& tint) -> void {
+    // Alpha in the tint is ignored as in the SDL renderer, where colors::WHITE has none
+    _instances.push_back({rect, rotation, {tint.r, tint.g, tint.b, 255}});
+
+    auto const index = static_cast<std::uint32_t>(_instances.size() - 1);
+    if (_batches.empty() || _batches.back().texture != texture) _batches.push_back({texture, index, 0});
+    ++_batches.back().count;
+}
+
+auto gl_renderer::flush() -> void {
+    if (_instances.empty()) return;
+
+    glUseProgram(_program);
+    glUniform2f(_camera_location, _camera.x, _camera.y);
+    glUniform2f(_logical_size_location, _logical_size.x, _logical_size.y);
+
+    glBindVertexArray(_vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, _instance_buffer);
+
+    // Orphan last flush's storage rather than wait for the GPU to finish reading it. GL 3.3 has no persistent
+    // mapping, and this is also what WebGL 2 supports.
+    if (_instances.size() > _instance_capacity) _instance_capacity = std::max(_instances.size(), _instance_capacity * 2);
+    auto const bytes = static_cast<GLsizeiptr>(_instances.size() * sizeof(sprite_instance));
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_instance_capacity * sizeof(sprite_instance)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, _instances.data());
+
+    glActiveTexture(GL_TEXTURE0);
+
+    // Without base instances (GL 4.2) each batch points the instance attributes at its first sprite instead
+    auto constexpr stride = static_cast<GLsizei>(sizeof(sprite_instance));
+    for (auto const& batch : _batches) {
+        auto const base = batch.first * sizeof(sprite_instance);
+        auto const* offset = reinterpret_cast<std::byte const*>(base);
+
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, offset + offsetof(sprite_instance, rect));
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, offset + offsetof(sprite_instance, rotation));
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, offset + offsetof(sprite_instance, tint));
+
+        glBindTexture(GL_TEXTURE_2D, _textures[batch.texture].id);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(batch.count));
+    }
 
+    _instances.clear();
+    _batches.clear();
 }
 
 auto gl_renderer::present() -> void {
-    // draw some stuff here...
-    glUseProgram(shader_program_id);
-    glBindVertexArray(vao_id);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    // no need to unbind the vertex array every time
+    flush();
 
     // swap
     SDL_GL_SwapWindow(reinterpret_cast<SDL_Window*>(sdl2_platform::window_handle()));
@@ -191,4 +289,4 @@ auto gl_renderer::resize(int width, int height) -> void {
     glViewport(0, 0, width, height);
 }
 
-} // namespace xc
\ No newline at end of file
+} // namespace xc
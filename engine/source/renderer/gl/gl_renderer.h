@@ -34,7 +34,37 @@ private:
     gl_renderer(int logical_width, int logical_height);
 
     auto resize(int width, int height) -> void;
+
+    // Sprites queued since the last flush, drawn as one instanced quad per run of the same texture
+    auto flush() -> void;
+
+    struct sprite_instance {
+        rectangle rect;             // top left and size in logical pixels, before the camera
+        float rotation;             // degrees clockwise about the centre
+        color tint;
+    };
+
+    struct sprite_batch {
+        resource_handle texture;
+        std::uint32_t first, count;
+    };
+
+    struct texture {
+        std::uint32_t id;
+        int width, height;
+    };
+
+    vector2 _logical_size;
+    vector2 _camera;
+
+    std::uint32_t _program = 0, _vertex_array = 0, _quad_buffer = 0, _instance_buffer = 0;
+    std::int32_t _camera_location = -1, _logical_size_location = -1;
+    std::size_t _instance_capacity = 0; // in instances
+
+    std::vector<sprite_instance> _instances;
+    std::vector<sprite_batch> _batches;
+    std::vector<texture> _textures;
 };
 }
 
-#endif // ENIGINE_RENDERER_GLES2_GLES2_RENDERER_H
\ No newline at end of file
+#endif // ENIGINE_RENDERER_GLES2_GLES2_RENDERER_H
@@ -0,0 +1,28 @@
+#version 450
+
+// Built three times. With NONUNIFORM_INDEXING each sprite in a draw may use a different texture; by default
+// every sprite in a draw must share one. SINGLE_TEXTURE is for devices that can't index the array at all: it
+// holds one texture, so every texture gets a descriptor set of its own.
+#if defined(NONUNIFORM_INDEXING)
+#extension GL_EXT_nonuniform_qualifier : require
+#define TEXTURE_SLOT(index) nonuniformEXT(index)
+#elif defined(SINGLE_TEXTURE)
+#define TEXTURE_SLOT(index) 0
+#else
+#define TEXTURE_SLOT(index) (index)
+#endif
+
+layout (constant_id = 0) const uint TEXTURE_CAPACITY = 1024;
+
+layout (location = 0) in vec2 uv;
+layout (location = 1) in vec4 color;
+layout (location = 2) flat in uint texture_index;
+
+layout (set = 0, binding = 0) uniform sampler2D textures[TEXTURE_CAPACITY];
+
+layout (location = 0) out vec4 frag_color;
+
+void main() {
+    // Handles past the array's capacity live in later sets, which the renderer binds in turn
+    frag_color = texture(textures[TEXTURE_SLOT(texture_index % TEXTURE_CAPACITY)], uv) * color;
+}
@@ -0,0 +1,31 @@
+#version 450
+
+layout (location = 0) in vec4 rect;
+layout (location = 1) in float rotation;
+layout (location = 2) in vec4 tint;
+layout (location = 3) in uint texture_slot;
+
+layout (push_constant) uniform view {
+    vec2 logical_size;
+};
+
+layout (location = 0) out vec2 uv;
+layout (location = 1) out vec4 color;
+layout (location = 2) flat out uint texture_index;
+
+void main() {
+    // Corners of a unit quad as a triangle strip: (0, 0), (1, 0), (0, 1), (1, 1)
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+
+    // Turn about the centre of the rectangle, clockwise on screen as in the SDL renderer. Vulkan's clip
+    // space already points y down, so unlike the GL shader there's nothing to flip.
+    float angle = radians(rotation);
+    vec2 offset = (corner - 0.5) * rect.zw;
+    vec2 turned = vec2(offset.x * cos(angle) - offset.y * sin(angle), offset.x * sin(angle) + offset.y * cos(angle));
+    vec2 position = (rect.xy + rect.zw * 0.5 + turned) / logical_size * 2.0 - 1.0;
+
+    gl_Position = vec4(position, 0.0, 1.0);
+    uv = corner;
+    color = tint;
+    texture_index = texture_slot;
+}
@@ -1,51 +1,1177 @@
 #include "vulkan_renderer.h"
+#include <core/logger.h>
+#include <platform/sdl2/sdl2_platform.h>
+
+// Every entry point is fetched through SDL's loader, so nothing links against libvulkan
+#define VK_NO_PROTOTYPES
+#include <vulkan/vulkan.h>
+#include <stb_image.h>
+#include <SDL.h>
+#include <SDL_vulkan.h>
+
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 
 namespace xc {
 
-vulkan_renderer::vulkan_renderer(int logical_width, int logical_height) {
+auto static constexpr FRAMES_IN_FLIGHT = std::uint32_t{2};
+auto static constexpr MAX_TEXTURES = std::uint32_t{1024}; // per descriptor set; fewer where the device can't bind that many samplers
+auto static constexpr INITIAL_INSTANCE_CAPACITY = std::size_t{4096}; // sprites per frame before the ring grows
+
+// Compiled from shaders/ by glslc at build time
+std::uint32_t static constexpr sprite_vertex_spirv[] = {
+#include "sprite.vert.inc"
+};
+
+std::uint32_t static constexpr sprite_fragment_spirv[] = {
+#include "sprite.frag.inc"
+};
+
+// The same shader built with NONUNIFORM_INDEXING, for devices that let each sprite pick its own texture
+std::uint32_t static constexpr sprite_nonuniform_fragment_spirv[] = {
+#include "sprite_nonuniform.frag.inc"
+};
+
+// And with SINGLE_TEXTURE, for devices that can only index descriptor arrays with constants
+std::uint32_t static constexpr sprite_single_fragment_spirv[] = {
+#include "sprite_single.frag.inc"
+};
+
+#define VULKAN_GLOBAL_FUNCTIONS(X) \
+    X(vkCreateInstance) \
+    X(vkEnumerateInstanceExtensionProperties)
+
+#define VULKAN_INSTANCE_FUNCTIONS(X) \
+    X(vkDestroyInstance) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceFeatures) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkDestroySurfaceKHR) \
+    X(vkCreateDevice) \
+    X(vkGetDeviceProcAddr)
+
+#define VULKAN_DEVICE_FUNCTIONS(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkResetCommandBuffer) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkWaitForFences) \
+    X(vkResetFences) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkBindBufferMemory) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkBindImageMemory) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdPushConstants) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDraw)
+
+#define VULKAN_DECLARE(name) PFN_##name static name = nullptr;
+PFN_vkGetInstanceProcAddr static vkGetInstanceProcAddr = nullptr;
+PFN_vkGetPhysicalDeviceFeatures2KHR static vkGetPhysicalDeviceFeatures2KHR = nullptr; // only with VK_KHR_get_physical_device_properties2
+VULKAN_GLOBAL_FUNCTIONS(VULKAN_DECLARE)
+VULKAN_INSTANCE_FUNCTIONS(VULKAN_DECLARE)
+VULKAN_DEVICE_FUNCTIONS(VULKAN_DECLARE)
+#undef VULKAN_DECLARE
+
+auto static check(VkResult const result, char const* what) -> void {
+    if (result != VK_SUCCESS) throw std::runtime_error(what);
+}
+
+auto static window() -> SDL_Window* {
+    return reinterpret_cast<SDL_Window*>(sdl2_platform::window_handle());
+}
+
+// Matches the push constant block in sprite.vert
+struct view_constants {
+    vector2 logical_size;
+};
+
+auto static has_extension(std::vector<VkExtensionProperties> const& extensions, char const* name) -> bool {
+    return std::any_of(extensions.begin(), extensions.end(), [name](auto const& extension) {
+        return std::strcmp(extension.extensionName, name) == 0;
+    });
+}
+
+struct vulkan_renderer::context {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+    VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    std::uint32_t queue_family = 0;
+
+    VkSurfaceFormatKHR surface_format{};
+    VkRenderPass render_pass = VK_NULL_HANDLE;
+
+    // Rebuilt whenever the window changes size; null while it has none
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkExtent2D extent{};
+    std::vector<VkImage> images;
+    std::vector<VkImageView> image_views;
+    std::vector<VkFramebuffer> framebuffers;
+    std::vector<VkSemaphore> render_finished; // per swapchain image, as presenting holds on to it
+
+    // Textures live in arrays of descriptors indexed by their handle, texture_capacity to a set: handle h is
+    // slot h % texture_capacity of set h / texture_capacity. Where the device allows it that's every texture in
+    // one set. Slots without a texture hold a blank one, as plain Vulkan 1.0 wants every element of a bound
+    // array to be valid.
+    std::uint32_t texture_capacity = MAX_TEXTURES;
+    bool dynamic_indexing = false;    // the array may be indexed at all, with the same index across a draw
+    bool nonuniform_indexing = false; // sprites in one draw may use different textures
+
+    VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> descriptor_pools;
+    std::vector<VkDescriptorSet> texture_sets;
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+
+    struct frame {
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+        VkSemaphore image_available = VK_NULL_HANDLE;
+        VkFence in_flight = VK_NULL_HANDLE; // signalled once the GPU is done with this frame's commands and instances
+    };
+
+    std::array<frame, FRAMES_IN_FLIGHT> frames{};
+    std::uint32_t frame_index = 0;
+
+    // Frame i writes its sprites to [i * instance_capacity, (i + 1) * instance_capacity); the fence that
+    // guards its command buffer guards its slice too
+    VkBuffer instance_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory instance_memory = VK_NULL_HANDLE;
+    std::byte* instance_data = nullptr;
+    std::size_t instance_capacity = 0;
+
+    struct texture {
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+        int width, height;
+    };
+
+    std::vector<texture> textures;
+    texture blank{};
+
+    auto create_instance() -> void;
+    auto pick_physical_device() -> void;
+    auto create_device() -> void;
+    auto create_render_pass() -> void;
+    auto create_pipeline() -> void;
+    auto create_frames() -> void;
+
+    auto create_swapchain() -> bool;
+    auto destroy_swapchain() -> void;
+    auto recreate_swapchain() -> void;
+
+    auto find_memory_type(std::uint32_t type_bits, VkMemoryPropertyFlags properties) const -> std::uint32_t;
+    auto create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                       VkBuffer& buffer, VkDeviceMemory& memory) const -> void;
+    auto reserve_instances(std::size_t count) -> void;
+    auto upload_texture(std::uint8_t const* pixels, int width, int height) -> texture;
+    auto write_texture_slots(VkDescriptorSet set, std::uint32_t first, std::uint32_t count, VkImageView view) const -> void;
+    auto add_texture_set() -> void;
+    auto create_blank_texture() -> void;
+};
+
+auto vulkan_renderer::context::create_instance() -> void {
+    vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(SDL_Vulkan_GetVkGetInstanceProcAddr());
+    if (!vkGetInstanceProcAddr) throw std::runtime_error(SDL_GetError());
+
+#define VULKAN_LOAD(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(VK_NULL_HANDLE, #name));
+    VULKAN_GLOBAL_FUNCTIONS(VULKAN_LOAD)
+#undef VULKAN_LOAD
+
+    // Whatever SDL needs to make a surface for this window
+    auto extension_count = 0u;
+    if (!SDL_Vulkan_GetInstanceExtensions(window(), &extension_count, nullptr)) throw std::runtime_error(SDL_GetError());
+    auto extensions = std::vector<char const*>(extension_count);
+    if (!SDL_Vulkan_GetInstanceExtensions(window(), &extension_count, extensions.data())) throw std::runtime_error(SDL_GetError());
+
+    // Needed to ask the device about descriptor indexing on a 1.0 instance
+    auto available_count = 0u;
+    vkEnumerateInstanceExtensionProperties(nullptr, &available_count, nullptr);
+    auto available = std::vector<VkExtensionProperties>(available_count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &available_count, available.data());
+
+    auto const has_properties2 = has_extension(available, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (has_properties2) extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    extension_count = static_cast<std::uint32_t>(extensions.size());
+
+    auto application_info = VkApplicationInfo{};
+    application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    application_info.pApplicationName = "cqprototype";
+    application_info.pEngineName = "xc";
+    application_info.apiVersion = VK_API_VERSION_1_0;
+
+    auto instance_info = VkInstanceCreateInfo{};
+    instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_info.pApplicationInfo = &application_info;
+    instance_info.enabledExtensionCount = extension_count;
+    instance_info.ppEnabledExtensionNames = extensions.data();
+
+    check(vkCreateInstance(&instance_info, nullptr, &instance), "Failed to create a Vulkan instance");
+
+#define VULKAN_LOAD(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+    VULKAN_INSTANCE_FUNCTIONS(VULKAN_LOAD)
+    if (has_properties2) VULKAN_LOAD(vkGetPhysicalDeviceFeatures2KHR)
+#undef VULKAN_LOAD
+
+    if (!SDL_Vulkan_CreateSurface(window(), instance, &surface)) throw std::runtime_error(SDL_GetError());
+}
+
+auto vulkan_renderer::context::pick_physical_device() -> void {
+    auto device_count = 0u;
+    vkEnumeratePhysicalDevices(instance, &device_count, nullptr);
+    auto devices = std::vector<VkPhysicalDevice>(device_count);
+    vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
+
+    // The first device that can draw to the window and present, preferring a GPU to a CPU implementation
+    auto best_score = -1;
+    for (auto candidate : devices) {
+        auto extension_count = 0u;
+        vkEnumerateDeviceExtensionProperties(candidate, nullptr, &extension_count, nullptr);
+        auto extensions = std::vector<VkExtensionProperties>(extension_count);
+        vkEnumerateDeviceExtensionProperties(candidate, nullptr, &extension_count, extensions.data());
+
+        if (!has_extension(extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME)) continue;
+
+        auto family_count = 0u;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &family_count, nullptr);
+        auto families = std::vector<VkQueueFamilyProperties>(family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &family_count, families.data());
+
+        for (auto family = 0u; family < family_count; ++family) {
+            auto can_present = VkBool32{VK_FALSE};
+            vkGetPhysicalDeviceSurfaceSupportKHR(candidate, family, surface, &can_present);
+            if (!(families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT) || !can_present) continue;
+
+            auto properties = VkPhysicalDeviceProperties{};
+            vkGetPhysicalDeviceProperties(candidate, &properties);
+            auto const score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? 0 : 1;
+
+            if (score > best_score) {
+                best_score = score;
+                physical_device = candidate;
+                queue_family = family;
+            }
+            break;
+        }
+    }
+
+    if (physical_device == VK_NULL_HANDLE) throw std::runtime_error("No Vulkan device can present to the window");
+
+    // As many textures as a fragment shader may sample from one set, which may be as few as 16. Without
+    // dynamic indexing the shader can only use a constant index, so each set holds a single texture.
+    auto properties = VkPhysicalDeviceProperties{};
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    auto features = VkPhysicalDeviceFeatures{};
+    vkGetPhysicalDeviceFeatures(physical_device, &features);
+
+    dynamic_indexing = features.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+    texture_capacity = !dynamic_indexing ? 1u : std::min({MAX_TEXTURES, properties.limits.maxPerStageDescriptorSamplers,
+                                                          properties.limits.maxPerStageDescriptorSampledImages,
+                                                          properties.limits.maxDescriptorSetSamplers,
+                                                          properties.limits.maxDescriptorSetSampledImages});
+
+    // Indexing the array with a different texture per sprite takes descriptor indexing. It's core in 1.2
+    // but an extension here, since the instance asks for 1.0.
+    if (dynamic_indexing && vkGetPhysicalDeviceFeatures2KHR) {
+        auto extension_count = 0u;
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr);
+        auto extensions = std::vector<VkExtensionProperties>(extension_count);
+        vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, extensions.data());
+
+        if (has_extension(extensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) && has_extension(extensions, VK_KHR_MAINTENANCE3_EXTENSION_NAME)) {
+            auto indexing = VkPhysicalDeviceDescriptorIndexingFeaturesEXT{};
+            indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+            auto features = VkPhysicalDeviceFeatures2KHR{};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+            features.pNext = &indexing;
+            vkGetPhysicalDeviceFeatures2KHR(physical_device, &features);
+
+            nonuniform_indexing = indexing.shaderSampledImageArrayNonUniformIndexing == VK_TRUE;
+        }
+    }
+
+    log_info("%s: texture descriptor sets hold %u each, %s", properties.deviceName, texture_capacity,
+             nonuniform_indexing ? "any mix of them per draw" : dynamic_indexing ? "one per draw" : "one set per texture");
+
+    auto format_count = 0u;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, nullptr);
+    auto formats = std::vector<VkSurfaceFormatKHR>(format_count);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &format_count, formats.data());
+    if (formats.empty()) throw std::runtime_error("The window has no Vulkan surface formats");
+
+    // Plain 8-bit UNORM, so colours come out as they do in the other renderers
+    surface_format = formats.front();
+    if (formats.size() == 1 && formats.front().format == VK_FORMAT_UNDEFINED) {
+        surface_format = {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+    } else {
+        for (auto const& format : formats) {
+            if (format.format == VK_FORMAT_B8G8R8A8_UNORM || format.format == VK_FORMAT_R8G8B8A8_UNORM) {
+                surface_format = format;
+                break;
+            }
+        }
+    }
+}
+
+auto vulkan_renderer::context::create_device() -> void {
+    auto const priority = 1.f;
+
+    auto queue_info = VkDeviceQueueCreateInfo{};
+    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_info.queueFamilyIndex = queue_family;
+    queue_info.queueCount = 1;
+    queue_info.pQueuePriorities = &priority;
+
+    auto extensions = std::vector<char const*>{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+    auto indexing = VkPhysicalDeviceDescriptorIndexingFeaturesEXT{};
+    indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+    indexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+
+    // Indexing the texture array with anything but a constant is an optional 1.0 feature
+    auto features = VkPhysicalDeviceFeatures{};
+    features.shaderSampledImageArrayDynamicIndexing = dynamic_indexing ? VK_TRUE : VK_FALSE;
+
+    auto device_info = VkDeviceCreateInfo{};
+    device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_info.queueCreateInfoCount = 1;
+    device_info.pQueueCreateInfos = &queue_info;
+    device_info.pEnabledFeatures = &features;
+
+    if (nonuniform_indexing) {
+        extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        device_info.pNext = &indexing;
+    }
+
+    device_info.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+    device_info.ppEnabledExtensionNames = extensions.data();
+
+    check(vkCreateDevice(physical_device, &device_info, nullptr, &device), "Failed to create a Vulkan device");
+
+#define VULKAN_LOAD(name) name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+    VULKAN_DEVICE_FUNCTIONS(VULKAN_LOAD)
+#undef VULKAN_LOAD
+
+    vkGetDeviceQueue(device, queue_family, 0, &queue);
+}
+
+auto vulkan_renderer::context::create_render_pass() -> void {
+    auto attachment = VkAttachmentDescription{};
+    attachment.format = surface_format.format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    auto const reference = VkAttachmentReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    auto subpass = VkSubpassDescription{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &reference;
+
+    // The layout transition waits for the acquire semaphore, which is waited on at colour output
+    auto dependency = VkSubpassDependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    auto render_pass_info = VkRenderPassCreateInfo{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = 1;
+    render_pass_info.pAttachments = &attachment;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
+
+    check(vkCreateRenderPass(device, &render_pass_info, nullptr, &render_pass), "Failed to create the render pass");
+}
+
+auto vulkan_renderer::context::create_pipeline() -> void {
+    auto const create_module = [this](std::uint32_t const* code, std::size_t size) {
+        auto module_info = VkShaderModuleCreateInfo{};
+        module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_info.codeSize = size;
+        module_info.pCode = code;
+
+        auto shader = VkShaderModule{};
+        check(vkCreateShaderModule(device, &module_info, nullptr, &shader), "Failed to create a shader module");
+        return shader;
+    };
+
+    auto const vertex_module = create_module(sprite_vertex_spirv, sizeof(sprite_vertex_spirv));
+    auto const fragment_module = nonuniform_indexing ? create_module(sprite_nonuniform_fragment_spirv, sizeof(sprite_nonuniform_fragment_spirv))
+                               : dynamic_indexing    ? create_module(sprite_fragment_spirv, sizeof(sprite_fragment_spirv))
+                                                     : create_module(sprite_single_fragment_spirv, sizeof(sprite_single_fragment_spirv));
+
+    auto stages = std::array<VkPipelineShaderStageCreateInfo, 2>{};
+    stages[0].sType = stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertex_module;
+    stages[0].pName = "main";
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragment_module;
+    stages[1].pName = "main";
+
+    // Sizes the shader's texture array to match the descriptor layout
+    auto const capacity_entry = VkSpecializationMapEntry{0, 0, sizeof(texture_capacity)};
+
+    auto specialization = VkSpecializationInfo{};
+    specialization.mapEntryCount = 1;
+    specialization.pMapEntries = &capacity_entry;
+    specialization.dataSize = sizeof(texture_capacity);
+    specialization.pData = &texture_capacity;
+    stages[1].pSpecializationInfo = &specialization;
+
+    // No vertex buffer: the shader makes the quad's corners from the vertex index, and everything else
+    // advances once per sprite
+    auto const binding = VkVertexInputBindingDescription{0, sizeof(sprite_instance), VK_VERTEX_INPUT_RATE_INSTANCE};
+    auto const attributes = std::array{
+        VkVertexInputAttributeDescription{0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(sprite_instance, rect)},
+        VkVertexInputAttributeDescription{1, 0, VK_FORMAT_R32_SFLOAT, offsetof(sprite_instance, rotation)},
+        VkVertexInputAttributeDescription{2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(sprite_instance, tint)},
+        VkVertexInputAttributeDescription{3, 0, VK_FORMAT_R32_UINT, offsetof(sprite_instance, texture)}
+    };
+
+    auto vertex_input = VkPipelineVertexInputStateCreateInfo{};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(attributes.size());
+    vertex_input.pVertexAttributeDescriptions = attributes.data();
+
+    auto input_assembly = VkPipelineInputAssemblyStateCreateInfo{};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+
+    auto viewport_state = VkPipelineViewportStateCreateInfo{};
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    auto rasterization = VkPipelineRasterizationStateCreateInfo{};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterization.lineWidth = 1.f;
+
+    auto multisample = VkPipelineMultisampleStateCreateInfo{};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    auto blend_attachment = VkPipelineColorBlendAttachmentState{};
+    blend_attachment.blendEnable = VK_TRUE;
+    blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    auto blend = VkPipelineColorBlendStateCreateInfo{};
+    blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    blend.attachmentCount = 1;
+    blend.pAttachments = &blend_attachment;
+
+    auto const dynamic_states = std::array{VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    auto dynamic = VkPipelineDynamicStateCreateInfo{};
+    dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic.dynamicStateCount = static_cast<std::uint32_t>(dynamic_states.size());
+    dynamic.pDynamicStates = dynamic_states.data();
+
+    auto sampler_binding = VkDescriptorSetLayoutBinding{};
+    sampler_binding.binding = 0;
+    sampler_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    sampler_binding.descriptorCount = texture_capacity;
+    sampler_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    auto layout_info = VkDescriptorSetLayoutCreateInfo{};
+    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &sampler_binding;
+    check(vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &descriptor_set_layout), "Failed to create the descriptor set layout");
+
+    auto const push_constants = VkPushConstantRange{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(view_constants)};
+
+    auto pipeline_layout_info = VkPipelineLayoutCreateInfo{};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_constants;
+    check(vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &pipeline_layout), "Failed to create the pipeline layout");
+
+    auto pipeline_info = VkGraphicsPipelineCreateInfo{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipeline_info.stageCount = static_cast<std::uint32_t>(stages.size());
+    pipeline_info.pStages = stages.data();
+    pipeline_info.pVertexInputState = &vertex_input;
+    pipeline_info.pInputAssemblyState = &input_assembly;
+    pipeline_info.pViewportState = &viewport_state;
+    pipeline_info.pRasterizationState = &rasterization;
+    pipeline_info.pMultisampleState = &multisample;
+    pipeline_info.pColorBlendState = &blend;
+    pipeline_info.pDynamicState = &dynamic;
+    pipeline_info.layout = pipeline_layout;
+    pipeline_info.renderPass = render_pass;
+    pipeline_info.subpass = 0;
+    check(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline), "Failed to create the sprite pipeline");
+
+    vkDestroyShaderModule(device, vertex_module, nullptr);
+    vkDestroyShaderModule(device, fragment_module, nullptr);
+
+    // Pixel art: no filtering, no bleeding in from the opposite edge
+    auto sampler_info = VkSamplerCreateInfo{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = 0.f;
+    check(vkCreateSampler(device, &sampler_info, nullptr, &sampler), "Failed to create the sampler");
+}
+
+auto vulkan_renderer::context::create_frames() -> void {
+    auto pool_info = VkCommandPoolCreateInfo{};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = queue_family;
+    check(vkCreateCommandPool(device, &pool_info, nullptr, &command_pool), "Failed to create the command pool");
+
+    auto semaphore_info = VkSemaphoreCreateInfo{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    // Signalled from the start so the first wait on each frame returns at once
+    auto fence_info = VkFenceCreateInfo{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (auto& frame : frames) {
+        auto allocate_info = VkCommandBufferAllocateInfo{};
+        allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.commandPool = command_pool;
+        allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocate_info.commandBufferCount = 1;
+
+        check(vkAllocateCommandBuffers(device, &allocate_info, &frame.commands), "Failed to allocate a command buffer");
+        check(vkCreateSemaphore(device, &semaphore_info, nullptr, &frame.image_available), "Failed to create a semaphore");
+        check(vkCreateFence(device, &fence_info, nullptr, &frame.in_flight), "Failed to create a fence");
+    }
 
+    reserve_instances(INITIAL_INSTANCE_CAPACITY);
+}
+
+auto vulkan_renderer::context::create_swapchain() -> bool {
+    auto capabilities = VkSurfaceCapabilitiesKHR{};
+    check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &capabilities), "Failed to query the surface");
+
+    extent = capabilities.currentExtent;
+    if (extent.width == ~0u) {
+        auto width = 0, height = 0;
+        SDL_Vulkan_GetDrawableSize(window(), &width, &height);
+
+        extent.width = std::clamp(static_cast<std::uint32_t>(width), capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        extent.height = std::clamp(static_cast<std::uint32_t>(height), capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
+
+    // Minimised: try again on a later frame
+    if (extent.width == 0 || extent.height == 0) return false;
+
+    auto image_count = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount != 0) image_count = std::min(image_count, capabilities.maxImageCount);
+
+    auto composite_alpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    for (auto const candidate : {VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR, VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+                                 VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR, VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR}) {
+        if (capabilities.supportedCompositeAlpha & candidate) {
+            composite_alpha = candidate;
+            break;
+        }
+    }
+
+    // FIFO is vsync and the one present mode every implementation has
+    auto swapchain_info = VkSwapchainCreateInfoKHR{};
+    swapchain_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapchain_info.surface = surface;
+    swapchain_info.minImageCount = image_count;
+    swapchain_info.imageFormat = surface_format.format;
+    swapchain_info.imageColorSpace = surface_format.colorSpace;
+    swapchain_info.imageExtent = extent;
+    swapchain_info.imageArrayLayers = 1;
+    swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchain_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    swapchain_info.preTransform = capabilities.currentTransform;
+    swapchain_info.compositeAlpha = composite_alpha;
+    swapchain_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    swapchain_info.clipped = VK_TRUE;
+
+    check(vkCreateSwapchainKHR(device, &swapchain_info, nullptr, &swapchain), "Failed to create the swapchain");
+
+    vkGetSwapchainImagesKHR(device, swapchain, &image_count, nullptr);
+    images.resize(image_count);
+    vkGetSwapchainImagesKHR(device, swapchain, &image_count, images.data());
+
+    auto semaphore_info = VkSemaphoreCreateInfo{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    image_views.resize(image_count);
+    framebuffers.resize(image_count);
+    render_finished.resize(image_count);
+
+    for (auto i = 0u; i < image_count; ++i) {
+        auto view_info = VkImageViewCreateInfo{};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = images[i];
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = surface_format.format;
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        check(vkCreateImageView(device, &view_info, nullptr, &image_views[i]), "Failed to create a swapchain image view");
+
+        auto framebuffer_info = VkFramebufferCreateInfo{};
+        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_info.renderPass = render_pass;
+        framebuffer_info.attachmentCount = 1;
+        framebuffer_info.pAttachments = &image_views[i];
+        framebuffer_info.width = extent.width;
+        framebuffer_info.height = extent.height;
+        framebuffer_info.layers = 1;
+        check(vkCreateFramebuffer(device, &framebuffer_info, nullptr, &framebuffers[i]), "Failed to create a framebuffer");
+
+        check(vkCreateSemaphore(device, &semaphore_info, nullptr, &render_finished[i]), "Failed to create a semaphore");
+    }
+
+    return true;
+}
+
+auto vulkan_renderer::context::destroy_swapchain() -> void {
+    for (auto framebuffer : framebuffers) vkDestroyFramebuffer(device, framebuffer, nullptr);
+    for (auto view : image_views) vkDestroyImageView(device, view, nullptr);
+    for (auto semaphore : render_finished) vkDestroySemaphore(device, semaphore, nullptr);
+
+    framebuffers.clear();
+    image_views.clear();
+    render_finished.clear();
+    images.clear();
+
+    if (swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device, swapchain, nullptr);
+    swapchain = VK_NULL_HANDLE;
+}
+
+auto vulkan_renderer::context::recreate_swapchain() -> void {
+    vkDeviceWaitIdle(device);
+    destroy_swapchain();
+    create_swapchain();
+}
+
+auto vulkan_renderer::context::find_memory_type(std::uint32_t const type_bits, VkMemoryPropertyFlags const properties) const -> std::uint32_t {
+    auto memory = VkPhysicalDeviceMemoryProperties{};
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &memory);
+
+    for (auto type = 0u; type < memory.memoryTypeCount; ++type)
+        if ((type_bits & (1u << type)) && (memory.memoryTypes[type].propertyFlags & properties) == properties) return type;
+
+    throw std::runtime_error("No suitable Vulkan memory type");
+}
+
+auto vulkan_renderer::context::create_buffer(VkDeviceSize const size, VkBufferUsageFlags const usage, VkMemoryPropertyFlags const properties,
+                                             VkBuffer& buffer, VkDeviceMemory& memory) const -> void {
+    auto buffer_info = VkBufferCreateInfo{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = usage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    check(vkCreateBuffer(device, &buffer_info, nullptr, &buffer), "Failed to create a buffer");
+
+    auto requirements = VkMemoryRequirements{};
+    vkGetBufferMemoryRequirements(device, buffer, &requirements);
+
+    auto allocate_info = VkMemoryAllocateInfo{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = find_memory_type(requirements.memoryTypeBits, properties);
+    check(vkAllocateMemory(device, &allocate_info, nullptr, &memory), "Failed to allocate buffer memory");
+
+    check(vkBindBufferMemory(device, buffer, memory, 0), "Failed to bind buffer memory");
+}
+
+auto vulkan_renderer::context::reserve_instances(std::size_t const count) -> void {
+    if (count <= instance_capacity) return;
+
+    // Every frame's slice moves, so nothing in flight may still be reading the old ring
+    if (instance_buffer != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(device);
+        vkUnmapMemory(device, instance_memory);
+        vkDestroyBuffer(device, instance_buffer, nullptr);
+        vkFreeMemory(device, instance_memory, nullptr);
+    }
+
+    instance_capacity = std::max(count, instance_capacity * 2);
+    auto const size = static_cast<VkDeviceSize>(instance_capacity * sizeof(sprite_instance) * FRAMES_IN_FLIGHT);
+
+    create_buffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  instance_buffer, instance_memory);
+
+    auto* data = static_cast<void*>(nullptr);
+    check(vkMapMemory(device, instance_memory, 0, VK_WHOLE_SIZE, 0, &data), "Failed to map the instance ring");
+    instance_data = static_cast<std::byte*>(data);
+}
+
+auto vulkan_renderer::context::upload_texture(std::uint8_t const* pixels, int const width, int const height) -> texture {
+    auto const size = static_cast<VkDeviceSize>(width) * static_cast<VkDeviceSize>(height) * 4;
+
+    auto staging = VkBuffer{};
+    auto staging_memory = VkDeviceMemory{};
+    create_buffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  staging, staging_memory);
+
+    auto* data = static_cast<void*>(nullptr);
+    check(vkMapMemory(device, staging_memory, 0, size, 0, &data), "Failed to map a staging buffer");
+    std::memcpy(data, pixels, static_cast<std::size_t>(size));
+    vkUnmapMemory(device, staging_memory);
+
+    auto result = texture{};
+    result.width = width;
+    result.height = height;
+
+    auto image_info = VkImageCreateInfo{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.extent = {static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height), 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    check(vkCreateImage(device, &image_info, nullptr, &result.image), "Failed to create a texture image");
+
+    auto requirements = VkMemoryRequirements{};
+    vkGetImageMemoryRequirements(device, result.image, &requirements);
+
+    auto allocate_info = VkMemoryAllocateInfo{};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.allocationSize = requirements.size;
+    allocate_info.memoryTypeIndex = find_memory_type(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    check(vkAllocateMemory(device, &allocate_info, nullptr, &result.memory), "Failed to allocate texture memory");
+    check(vkBindImageMemory(device, result.image, result.memory, 0), "Failed to bind texture memory");
+
+    // Copy on a one-off command buffer, moving the image into place for the copy and then for sampling
+    auto commands = VkCommandBuffer{};
+    auto command_info = VkCommandBufferAllocateInfo{};
+    command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_info.commandPool = command_pool;
+    command_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_info.commandBufferCount = 1;
+    check(vkAllocateCommandBuffers(device, &command_info, &commands), "Failed to allocate a command buffer");
+
+    auto begin_info = VkCommandBufferBeginInfo{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commands, &begin_info);
+
+    auto barrier = VkImageMemoryBarrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = result.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    auto region = VkBufferImageCopy{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = image_info.extent;
+    vkCmdCopyBufferToImage(commands, staging, result.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkEndCommandBuffer(commands);
+
+    auto submit_info = VkSubmitInfo{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &commands;
+    check(vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE), "Failed to submit a texture upload");
+
+    // Textures are loaded up front, so waiting here costs nothing during play
+    vkQueueWaitIdle(queue);
+    vkFreeCommandBuffers(device, command_pool, 1, &commands);
+    vkDestroyBuffer(device, staging, nullptr);
+    vkFreeMemory(device, staging_memory, nullptr);
+
+    auto view_info = VkImageViewCreateInfo{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = result.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    view_info.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    check(vkCreateImageView(device, &view_info, nullptr, &result.view), "Failed to create a texture view");
+
+    return result;
+}
+
+// The upload above has already waited for the queue, so no frame in flight is using the set
+auto vulkan_renderer::context::write_texture_slots(VkDescriptorSet const set, std::uint32_t const first, std::uint32_t const count,
+                                                   VkImageView const view) const -> void {
+    auto const image_descriptors = std::vector<VkDescriptorImageInfo>(count, {sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+
+    auto write = VkWriteDescriptorSet{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.dstArrayElement = first;
+    write.descriptorCount = count;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = image_descriptors.data();
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+// Room for the next texture_capacity handles. Each pool holds about MAX_TEXTURES descriptors, however many
+// sets that makes.
+auto vulkan_renderer::context::add_texture_set() -> void {
+    auto const sets_per_pool = std::max(1u, MAX_TEXTURES / texture_capacity);
+
+    if (texture_sets.size() % sets_per_pool == 0) {
+        auto const pool_size = VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sets_per_pool * texture_capacity};
+
+        auto pool_info = VkDescriptorPoolCreateInfo{};
+        pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_info.maxSets = sets_per_pool;
+        pool_info.poolSizeCount = 1;
+        pool_info.pPoolSizes = &pool_size;
+        check(vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pools.emplace_back()), "Failed to create a descriptor pool");
+    }
+
+    auto set_info = VkDescriptorSetAllocateInfo{};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = descriptor_pools.back();
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &descriptor_set_layout;
+    check(vkAllocateDescriptorSets(device, &set_info, &texture_sets.emplace_back()), "Failed to allocate texture descriptors");
+
+    write_texture_slots(texture_sets.back(), 0, texture_capacity, blank.view);
+}
+
+auto vulkan_renderer::context::create_blank_texture() -> void {
+    auto constexpr white = std::array<std::uint8_t, 4>{255, 255, 255, 255};
+
+    blank = upload_texture(white.data(), 1, 1);
+    add_texture_set();
+}
+
+vulkan_renderer::vulkan_renderer(int const logical_width, int const logical_height)
+    : _context{std::make_unique<context>()},
+      _logical_size{static_cast<float>(logical_width), static_cast<float>(logical_height)},
+      _camera{0.f, 0.f}, _clear_color{colors::BLACK} {
+    _context->create_instance();
+    _context->pick_physical_device();
+    _context->create_device();
+    _context->create_render_pass();
+    _context->create_pipeline();
+    _context->create_frames();
+    _context->create_blank_texture();
+    _context->create_swapchain();
 }
 
 vulkan_renderer::~vulkan_renderer() {
+    auto& vulkan = *_context;
+    vkDeviceWaitIdle(vulkan.device);
+
+    auto const destroy_texture = [&vulkan](context::texture const& texture) {
+        vkDestroyImageView(vulkan.device, texture.view, nullptr);
+        vkDestroyImage(vulkan.device, texture.image, nullptr);
+        vkFreeMemory(vulkan.device, texture.memory, nullptr);
+    };
 
+    for (auto const& texture : vulkan.textures) destroy_texture(texture);
+    destroy_texture(vulkan.blank);
+
+    vkUnmapMemory(vulkan.device, vulkan.instance_memory);
+    vkDestroyBuffer(vulkan.device, vulkan.instance_buffer, nullptr);
+    vkFreeMemory(vulkan.device, vulkan.instance_memory, nullptr);
+
+    for (auto const& frame : vulkan.frames) {
+        vkDestroySemaphore(vulkan.device, frame.image_available, nullptr);
+        vkDestroyFence(vulkan.device, frame.in_flight, nullptr);
+    }
+
+    vulkan.destroy_swapchain();
+
+    vkDestroyCommandPool(vulkan.device, vulkan.command_pool, nullptr);
+    for (auto pool : vulkan.descriptor_pools) vkDestroyDescriptorPool(vulkan.device, pool, nullptr);
+    vkDestroySampler(vulkan.device, vulkan.sampler, nullptr);
+    vkDestroyPipeline(vulkan.device, vulkan.pipeline, nullptr);
+    vkDestroyPipelineLayout(vulkan.device, vulkan.pipeline_layout, nullptr);
+    vkDestroyDescriptorSetLayout(vulkan.device, vulkan.descriptor_set_layout, nullptr);
+    vkDestroyRenderPass(vulkan.device, vulkan.render_pass, nullptr);
+    vkDestroyDevice(vulkan.device, nullptr);
+
+    vkDestroySurfaceKHR(vulkan.instance, vulkan.surface, nullptr);
+    vkDestroyInstance(vulkan.instance, nullptr);
 }
 
 auto vulkan_renderer::create_texture(char const* path) -> resource_handle {
+    auto width = 0, height = 0, source_format = 0;
+
+    auto& vulkan = *_context;
+
+    auto* image = stbi_load(path, &width, &height, &source_format, STBI_rgb_alpha);
+    if (!image) throw std::runtime_error(stbi_failure_reason());
 
+    vulkan.textures.push_back(vulkan.upload_texture(image, width, height));
+    stbi_image_free(image);
+
+    auto const handle = static_cast<resource_handle>(vulkan.textures.size() - 1);
+    if (handle / vulkan.texture_capacity == vulkan.texture_sets.size()) vulkan.add_texture_set();
+    vulkan.write_texture_slots(vulkan.texture_sets[handle / vulkan.texture_capacity], handle % vulkan.texture_capacity, 1, vulkan.textures.back().view);
+
+    return handle;
 }
 
 auto vulkan_renderer::texture_size(resource_handle texture) -> vector2 {
-
+    auto const& entry = _context->textures.at(texture);
+    return vector2{static_cast<float>(entry.width), static_cast<float>(entry.height)};
 }
 
 auto vulkan_renderer::set_camera(vector2 const& camera) -> void {
-
+    _camera = camera;
 }
 
+// The render pass clears as it begins, so anything queued before this would be cleared away
 auto vulkan_renderer::clear_screen(color const& clear_color) -> void {
-
+    _clear_color = clear_color;
+    _instances.clear();
 }
 
 auto vulkan_renderer::draw_texture(resource_handle          texture,
                           rectangle         const& rect) -> void {
-
-};
+    draw_texture(texture, rect, 0.f, colors::WHITE);
+}
 
 auto vulkan_renderer::draw_texture(resource_handle          texture,
                           rectangle         const& rect,
                           float                    rotation) -> void {
-
+    draw_texture(texture, rect, rotation, colors::WHITE);
 }
 
 auto vulkan_renderer::draw_texture(resource_handle          texture,
                           rectangle         const& rect,
                           float                    rotation,
                           color             const& tint) -> void {
-
+    // The camera is applied here so a change of camera doesn't split the frame's draw. Alpha in the tint
+    // is ignored as in the SDL renderer, where colors::WHITE has none.
+    auto const placed = rectangle{rect.x - _camera.x, rect.y - _camera.y, rect.w, rect.h};
+    _instances.push_back({placed, rotation, {tint.r, tint.g, tint.b, 255}, texture});
 }
 
-auto vulkan_renderer:: present() -> void {
+auto vulkan_renderer::present() -> void {
+    auto& vulkan = *_context;
+    auto& frame = vulkan.frames[vulkan.frame_index];
+
+    auto const drop_frame = [this] { _instances.clear(); };
+
+    if (vulkan.swapchain == VK_NULL_HANDLE && !vulkan.create_swapchain()) return drop_frame();
+
+    // Wait until the GPU is done with this frame's command buffer and slice of the ring
+    vkWaitForFences(vulkan.device, 1, &frame.in_flight, VK_TRUE, ~std::uint64_t{0});
+
+    auto image_index = 0u;
+    auto result = vkAcquireNextImageKHR(vulkan.device, vulkan.swapchain, ~std::uint64_t{0}, frame.image_available, VK_NULL_HANDLE, &image_index);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        vulkan.recreate_swapchain();
+        return drop_frame();
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) throw std::runtime_error("Failed to acquire a swapchain image");
+
+    vkResetFences(vulkan.device, 1, &frame.in_flight);
+
+    // Growing the ring waits for every frame, so the slice below is free either way
+    vulkan.reserve_instances(_instances.size());
+    auto const ring_offset = static_cast<VkDeviceSize>(vulkan.frame_index * vulkan.instance_capacity * sizeof(sprite_instance));
+    if (!_instances.empty())
+        std::memcpy(vulkan.instance_data + ring_offset, _instances.data(), _instances.size() * sizeof(sprite_instance));
+
+    auto const commands = frame.commands;
+    vkResetCommandBuffer(commands, 0);
+
+    auto begin_info = VkCommandBufferBeginInfo{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    check(vkBeginCommandBuffer(commands, &begin_info), "Failed to begin a command buffer");
+
+    auto clear_value = VkClearValue{};
+    clear_value.color.float32[0] = _clear_color.r / 255.f;
+    clear_value.color.float32[1] = _clear_color.g / 255.f;
+    clear_value.color.float32[2] = _clear_color.b / 255.f;
+    clear_value.color.float32[3] = 1.f;
+
+    auto render_pass_info = VkRenderPassBeginInfo{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_info.renderPass = vulkan.render_pass;
+    render_pass_info.framebuffer = vulkan.framebuffers[image_index];
+    render_pass_info.renderArea = {{0, 0}, vulkan.extent};
+    render_pass_info.clearValueCount = 1;
+    render_pass_info.pClearValues = &clear_value;
+    vkCmdBeginRenderPass(commands, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+
+    // The logical screen scaled by a whole number where the window allows, centred, as the SDL renderer does
+    auto const width = static_cast<float>(vulkan.extent.width), height = static_cast<float>(vulkan.extent.height);
+    auto scale = std::min(width / _logical_size.x, height / _logical_size.y);
+    if (scale >= 1.f) scale = std::floor(scale);
 
+    auto viewport = VkViewport{};
+    viewport.width = _logical_size.x * scale;
+    viewport.height = _logical_size.y * scale;
+    viewport.x = std::floor((width - viewport.width) * 0.5f);
+    viewport.y = std::floor((height - viewport.height) * 0.5f);
+    viewport.maxDepth = 1.f;
+    vkCmdSetViewport(commands, 0, 1, &viewport);
+
+    auto const scissor = VkRect2D{{static_cast<std::int32_t>(viewport.x), static_cast<std::int32_t>(viewport.y)},
+                                  {static_cast<std::uint32_t>(viewport.width), static_cast<std::uint32_t>(viewport.height)}};
+    vkCmdSetScissor(commands, 0, 1, &scissor);
+
+    auto const constants = view_constants{_logical_size};
+    vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan.pipeline);
+    vkCmdBindVertexBuffers(commands, 0, 1, &vulkan.instance_buffer, &ring_offset);
+    vkCmdPushConstants(commands, vulkan.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+
+    // A draw covers a run of sprites whose textures share a set, which with every texture in one set is the
+    // whole frame. Without nonuniform indexing the index must also be the same across a draw, so the run is
+    // one texture.
+    auto const capacity = vulkan.texture_capacity;
+    auto const count = static_cast<std::uint32_t>(_instances.size());
+    auto bound_set = ~std::uint32_t{0};
+
+    for (auto first = 0u; first < count;) {
+        auto const texture = _instances[first].texture;
+        auto last = first + 1;
+        while (last < count && (vulkan.nonuniform_indexing ? _instances[last].texture / capacity == texture / capacity
+                                                           : _instances[last].texture == texture)) ++last;
+
+        if (texture / capacity != bound_set) {
+            bound_set = texture / capacity;
+            vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan.pipeline_layout, 0, 1,
+                                    &vulkan.texture_sets.at(bound_set), 0, nullptr);
+        }
+
+        vkCmdDraw(commands, 4, last - first, 0, first);
+        first = last;
+    }
+
+    vkCmdEndRenderPass(commands);
+    check(vkEndCommandBuffer(commands), "Failed to record the frame");
+
+    auto const wait_stage = VkPipelineStageFlags{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+
+    auto submit_info = VkSubmitInfo{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.waitSemaphoreCount = 1;
+    submit_info.pWaitSemaphores = &frame.image_available;
+    submit_info.pWaitDstStageMask = &wait_stage;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &commands;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &vulkan.render_finished[image_index];
+    check(vkQueueSubmit(vulkan.queue, 1, &submit_info, frame.in_flight), "Failed to submit the frame");
+
+    auto present_info = VkPresentInfoKHR{};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &vulkan.render_finished[image_index];
+    present_info.swapchainCount = 1;
+    present_info.pSwapchains = &vulkan.swapchain;
+    present_info.pImageIndices = &image_index;
+
+    result = vkQueuePresentKHR(vulkan.queue, &present_info);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) vulkan.recreate_swapchain();
+    else if (result != VK_SUCCESS) throw std::runtime_error("Failed to present");
+
+    vulkan.frame_index = (vulkan.frame_index + 1) % FRAMES_IN_FLIGHT;
+    drop_frame();
 }
 
-}
\ No newline at end of file
+}
@@ -5,6 +5,12 @@
 
 namespace xc {
 
+// Sprites are queued during the frame and recorded at present() into the command buffer of one of a few
+// frames in flight, with their instance data written straight into that frame's part of a persistently
+// mapped ring buffer. Textures sit in descriptor arrays indexed by their handle, as many to an array as the
+// device allows, so where it can index one per sprite (descriptor indexing) the whole frame is a single draw
+// per array; otherwise it's one draw per run of the same texture. Needs nothing past Vulkan 1.0 and the
+// swapchain, so it also runs on lavapipe.
 class vulkan_renderer : public renderer {
     friend class renderer;
 
@@ -32,8 +38,25 @@ public:
 
 private:
     vulkan_renderer(int logical_width, int logical_height);
+
+    struct sprite_instance {
+        rectangle rect;             // top left and size in logical pixels, camera already subtracted
+        float rotation;             // degrees clockwise about the centre
+        color tint;
+        resource_handle texture;    // picks the texture array and the slot in it
+    };
+
+    // Vulkan objects, kept out of this header so the rest of the engine doesn't see vulkan.h
+    struct context;
+    std::unique_ptr<context> _context;
+
+    vector2 _logical_size;
+    vector2 _camera;
+    color _clear_color;
+
+    std::vector<sprite_instance> _instances;
 };
 
 }
 
-#endif // ENGINE_RENDERER_VULKAN_VULKAN_RENDERER_H
\ No newline at end of file
+#endif // ENGINE_RENDERER_VULKAN_VULKAN_RENDERER_H
@@ -6,12 +6,13 @@
 #include <any>
 #include <map>
 #include <bitset>
+#include <functional>
 #include <vector>
 #include <typeindex>
 
 namespace xc {
 
-auto static component_id_pool = std::size_t{0};
+auto inline component_id_pool = std::size_t{0};
 using signature_type = std::bitset<sizeof(entity_id) << 3>;
 
 class scene : public std::enable_shared_from_this<scene> {
@@ -62,6 +63,11 @@ public:
         return std::any_cast<std::vector<T>&>(_pools[lookup<T>::id()])[entity];
     }
 
+    // The whole pool indexed by entity, for systems that touch many components per frame
+    template<class T> [[nodiscard]] auto inline get_components() -> std::vector<T>& {
+        return std::any_cast<std::vector<T>&>(_pools[lookup<T>::id()]);
+    }
+
     struct view_t {
         std::shared_ptr<scene> world;
         std::vector<entity_id> entities;
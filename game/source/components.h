@@ -7,6 +7,7 @@ struct gate_tag {};
 struct player_tag {};
 struct crystal_tag {};
 
+// Only for entities without a physics body; a body's position is its transform
 struct transform_component {
     xc::vector2 position;
 };
@@ -20,6 +20,11 @@ auto static MAP_WIDTH = 2000.f;
 auto static MAP_HEIGHT = 2000.f;
 auto static MAP_CELL_SIZE = 64.f;
 
+// Collision categories
+auto static constexpr PLAYER_CATEGORY = 1u << 0;
+auto static constexpr CRYSTAL_CATEGORY = 1u << 1;
+auto static constexpr GATE_CATEGORY = 1u << 2;
+
 // Player
 auto static constexpr PLAYER_TEXTURE_PATH = "assets/player.png";
 auto static constexpr PLAYER_THRUST = 10'000.f;
@@ -32,13 +37,11 @@ auto static constexpr CRYSTAL_TEXTURE_PATH = "assets/crystal.png";
 auto static constexpr CRYSTAL_SPAWN_PROBABILITY = 28;
 auto static constexpr CRYSTAL_WIDTH = 16.f;
 auto static constexpr CRYSTAL_HEIGHT = 16.f;
-auto static constexpr CRYSTAL_RADIUS = xc::radius_of_rectangle(CRYSTAL_WIDTH, CRYSTAL_HEIGHT); // fully encloses rect
 
 // Gate
 auto static constexpr GATE_TEXTURE_PATH = "assets/gate.png";
 auto static constexpr GATE_SPAWN_PROBABILITY = 128;
 auto static constexpr GATE_WIDTH = 48.f;
 auto static constexpr GATE_HEIGHT = 48.f;
-auto static constexpr GATE_RADIUS = GATE_WIDTH / 2.f;
 
 #endif // GAME_CONSTANTS_H
\ No newline at end of file
@@ -35,7 +35,7 @@ auto game::initialize() -> void {
     _renderer = xc::renderer::create(LOGICAL_WIDTH, LOGICAL_HEIGHT);
     _scene = xc::scene::create();
 
-    _physics = xc::physics::create(_scene);
+    _physics = xc::physics::create(_scene, xc::broadphase_type::eGrid, MAP_CELL_SIZE);
     _scripting = xc::scripting::create();
 
     _timer.reset();
@@ -64,23 +64,26 @@ auto game::tick() -> void {
     accumulator += frame_time;
 
     while (accumulator >= TIME_STEP) {
-        update_player(_scene, _player, TIME_STEP, _physics);
+        update_player(_player, _physics);
 
         _physics->tick(TIME_STEP);
 
-        collect_crystals(_scene, _player);
-        update_camera(_scene, _camera, _renderer);
+        collect_crystals(_scene, _player, _physics);
 
         accumulator -= TIME_STEP;
         elapsed_time += TIME_STEP;
     }
 
+    // How far the display time has got into the next step
+    auto const alpha = static_cast<float>(accumulator / TIME_STEP);
+    update_camera(_scene, _camera, alpha, _physics, _renderer);
+
     _renderer->clear_screen(xc::colors::CORNFLOWER_BLUE);
 
     draw_crystals(_scene, _renderer);
     draw_gates(_scene, _renderer);
 
-    draw_player(_scene, _player, _renderer);
+    draw_player(_scene, _player, alpha, _physics, _renderer);
 
     _renderer->present();
 }
\ No newline at end of file
@@ -5,21 +5,21 @@
 #include "constants.h"
 #include "components.h"
 
-auto collect_crystals(std::shared_ptr<xc::scene>& scene, xc::entity_id player) -> void {
-    if (scene->has_component<collision_component>(player)) {
+auto collect_crystals(std::shared_ptr<xc::scene>& scene, xc::entity_id player, std::shared_ptr<xc::physics>& physics) -> void {
+    for (auto const& event : physics->contact_events()) {
+        if (event.phase != xc::contact_phase::eBegin) continue;
+        if (event.pair.a != player && event.pair.b != player) continue;
+
         // Get the other entity
-        auto collider_entity = scene->get_component<collision_component>(player).collider;
+        auto collider_entity = event.pair.a == player ? event.pair.b : event.pair.a;
 
-        // Return if it's not a crystal
-        if (!scene->has_component<collectable_component>(collider_entity)) return;
+        // Skip it if it's not a crystal
+        if (!scene->has_component<collectable_component>(collider_entity)) continue;
 
         // Increment the player's collection counter
         auto& count = scene->get_component<collector_component>(player).count;
         ++count;
 
-        // Remove the collision from the player
-        scene->remove_component<collision_component>(player);
-
         // Remove the crystal entity and therefore all it's components
         scene->remove_entity(collider_entity);
     }
@@ -29,35 +29,32 @@ auto create_player(std::shared_ptr<xc::scene>& scene, std::shared_ptr<xc::physic
     auto texture = renderer->create_texture(PLAYER_TEXTURE_PATH);
     auto player = scene->create_entity();
 
-    auto& transform = scene->add_component<transform_component>(player, xc::vector2{
-        CENTER_X, CENTER_Y});
-
     scene->add_component<collector_component>(player, 0u);
 
     scene->add_component<texture_component>(player, texture, PLAYER_WIDTH, PLAYER_HEIGHT);
 
-    auto body = physics->create_body(transform.position, PLAYER_RADIUS, true);
+    // The body is the player's only transform; physics moves it in place
+    auto body = physics->create_body({CENTER_X, CENTER_Y}, PLAYER_RADIUS, true);
+    body.category = PLAYER_CATEGORY;
+    body.mask = CRYSTAL_CATEGORY | GATE_CATEGORY;
     scene->add_component<physics_body_component>(player, body);
     // TODO: cap the maximum velocity
 
     return player;
 }
 
-auto update_player(std::shared_ptr<xc::scene>& scene, xc::entity_id player, float const step, std::shared_ptr<xc::physics>& physics) -> void {
-    auto& body  = scene->get_component<physics_body_component>(player);
-    auto& position = scene->get_component<transform_component>(player).position = body.position; // sync transform
-
+auto update_player(xc::entity_id player, std::shared_ptr<xc::physics>& physics) -> void {
     if (xc::input::is_key_down(xc::key::eW)) physics->add_force(player, {0.f, -PLAYER_THRUST});
     if (xc::input::is_key_down(xc::key::eA)) physics->add_force(player, {-PLAYER_THRUST, 0});
     if (xc::input::is_key_down(xc::key::eS)) physics->add_force(player, {0, PLAYER_THRUST});
     if (xc::input::is_key_down(xc::key::eD)) physics->add_force(player, {PLAYER_THRUST, 0});
 }
 
-auto draw_player(std::shared_ptr<xc::scene>& scene, xc::entity_id player, std::shared_ptr<xc::renderer>& renderer) -> void {
+auto draw_player(std::shared_ptr<xc::scene>& scene, xc::entity_id player, float const alpha, std::shared_ptr<xc::physics>& physics, std::shared_ptr<xc::renderer>& renderer) -> void {
     auto& texture = scene->get_component<texture_component>(player);
 
-    // get transform and sync with physics
-    auto& position = scene->get_component<transform_component>(player).position;
+    // Drawn between the last two physics steps rather than snapping to the latest one
+    auto const position = physics->interpolated_pose(player, alpha).position;
 
     renderer->draw_texture(texture.resource, {position.x, position.y, texture.width, texture.height});
 }
@@ -82,20 +79,22 @@ auto spawn_crystals(std::shared_ptr<xc::scene>& scene, std::shared_ptr<xc::physi
         auto entity = scene->create_entity();
         scene->add_component<crystal_tag>(entity);
         scene->add_component<collectable_component>(entity);
-        scene->add_component<transform_component>(entity, position);
         scene->add_component<texture_component>(entity, texture, CRYSTAL_WIDTH, CRYSTAL_HEIGHT);
 
-        auto body = physics->create_body(position, CRYSTAL_RADIUS);
+        auto body = physics->create_box(position, {CRYSTAL_WIDTH / 2.f, CRYSTAL_HEIGHT / 2.f}, false);
+        body.category = CRYSTAL_CATEGORY;
+        body.mask = PLAYER_CATEGORY;
+        body.is_sensor = true;
         scene->add_component<physics_body_component>(entity, body);
     }
 }
 
 auto draw_crystals(std::shared_ptr<xc::scene>& scene, std::shared_ptr<xc::renderer>& renderer) -> void {
-    auto crystals = scene->view<crystal_tag, texture_component, transform_component>().entities;
+    auto crystals = scene->view<crystal_tag, texture_component, physics_body_component>().entities;
 
     for (auto const& crystal : crystals) {
         auto& texture = scene->get_component<texture_component>(crystal);
-        auto& position = scene->get_component<transform_component>(crystal).position;
+        auto const position = xc::to_vector2(scene->get_component<physics_body_component>(crystal).position);
 
         renderer->draw_texture(texture.resource, {position.x, position.y, texture.width, texture.height});
     }
@@ -128,30 +127,34 @@ auto spawn_gates(std::shared_ptr<xc::scene>& scene, std::shared_ptr<xc::physics>
 
         auto entity = scene->create_entity();
         scene->add_component<gate_tag>(entity);
-        scene->add_component<transform_component>(entity, position);
         scene->add_component<texture_component>(entity, texture, GATE_WIDTH, GATE_HEIGHT);
 
-        auto body = physics->create_body(position, GATE_RADIUS);
+        auto body = physics->create_box(position, {GATE_WIDTH / 2.f, GATE_HEIGHT / 2.f}, false);
+        body.category = GATE_CATEGORY;
+        body.mask = PLAYER_CATEGORY;
         scene->add_component<physics_body_component>(entity, body);
     }
 }
 
 auto draw_gates(std::shared_ptr<xc::scene>& scene, std::shared_ptr<xc::renderer>& renderer) -> void {
-    auto gate_entities = scene->view<gate_tag, texture_component, transform_component>().entities;
+    auto gate_entities = scene->view<gate_tag, texture_component, physics_body_component>().entities;
 
     for (auto const& gate_entity : gate_entities) {
         auto& texture = scene->get_component<texture_component>(gate_entity);
-        auto& position = scene->get_component<transform_component>(gate_entity).position;
+        auto const position = xc::to_vector2(scene->get_component<physics_body_component>(gate_entity).position);
 
         renderer->draw_texture(texture.resource, {position.x, position.y, texture.width, texture.height});
     }
 }
 
-auto update_camera(std::shared_ptr<xc::scene>& scene, xc::entity_id camera_entity, std::shared_ptr<xc::renderer>& renderer) -> void {
+auto update_camera(std::shared_ptr<xc::scene>& scene, xc::entity_id camera_entity, float const alpha, std::shared_ptr<xc::physics>& physics, std::shared_ptr<xc::renderer>& renderer) -> void {
     auto& camera = scene->get_component<camera_component>(camera_entity);
     auto& camera_position = scene->get_component<transform_component>(camera_entity);
 
-    auto& target_position = scene->get_component<transform_component>(camera.target).position;
+    // Follow the target where it's drawn, or it shakes against the background
+    auto const target_position = scene->has_component<physics_body_component>(camera.target)
+        ? physics->interpolated_pose(camera.target, alpha).position
+        : scene->get_component<transform_component>(camera.target).position;
     camera_position.position = target_position - camera.offset;
 
     renderer->set_camera(scene->get_component<transform_component>(camera_entity).position);